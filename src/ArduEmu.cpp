@@ -34,6 +34,7 @@
 
 #include "utils/byteVisualiser.h"
 #include "utils/asmViewer.h"
+#include "utils/hexLoader.h"
 #include "StringUtils.h"
 
 #include "imgui/icons.h"
@@ -305,9 +306,9 @@ void ArduEmu::drawBenchmark(){
 		if(ImGui::Button("Do Benchmark")){
 			std::unique_ptr<ABB::Console> mcu = genConsole(ARDUBOY); // TODO
 			try {
-				std::string content = StringUtils::loadFileIntoString(benchmarkProgPath.c_str());
-				auto data = StringUtils::parseHexFileStr(content.c_str(), content.c_str()+content.size());
-				mcu->flash_loadFromMemory(data.size()?&data[0]:nullptr, data.size());
+				std::vector<uint8_t> data(mcu->flash_size(), 0);
+				size_t len = ABB::utils::IntelHex::decodeFile(benchmarkProgPath.c_str(), data.data(), data.size());
+				mcu->flash_loadFromMemory(len?data.data():nullptr, len);
 			}catch(const std::exception& e) {
 				res = StringUtils::format("Error loading file: %s", e.what()) + res;
 			}
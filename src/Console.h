@@ -96,6 +96,9 @@ namespace ABB {
 		// Disassembler
 		virtual pc_t disassembler_getJumpDests(uint16_t word, uint16_t word2, pc_t pc) = 0;
 		virtual std::string disassembler_disassembleRaw(uint16_t word, uint16_t word2) = 0;
+		virtual uint8_t disassembler_getInstCycles(uint16_t word) = 0; // cycles of the instruction if no branch is taken/nothing is skipped
+		virtual bool disassembler_isCall(uint16_t word) = 0;
+		virtual uint8_t disassembler_getInstLen(uint16_t word) = 0; // in words
 		virtual std::string disassembler_disassembleProg(
 			const std::vector<std::pair<uint32_t, std::string>>* srcLines = nullptr,
 			const std::vector<std::pair<uint32_t, std::string>>* funcSymbs = nullptr,
@@ -128,7 +131,11 @@ namespace ABB {
 		virtual void analytics_setSleepSum(uint64_t val) = 0;
 		virtual void analytics_resetPCHeat() = 0;
 		virtual uint64_t analytics_getPCHeat(pc_t pc) const = 0;
+		virtual uint64_t analytics_getPCCycles(pc_t pc) const = 0; // estimated cycles spent executing the instruction at pc (derived from the execution counts)
 		virtual uint64_t analytics_getInstHeat(size_t ind) const = 0;
+		virtual const uint64_t* analytics_getRamReads() = 0;
+		virtual const uint64_t* analytics_getRamWrites() = 0;
+		virtual void analytics_resetRamReadsWrites() = 0;
 
 
 		enum {
@@ -145,7 +152,10 @@ namespace ABB {
 			uint8_t type;
 			uint32_t val;
 		};
-		virtual ParamInfo getParamInfo(const char* start, const char* end, const char* instStart, const char* instEnd, uint32_t pcAddr) const = 0;
+		// parses a parameter of a disassembled instruction only from its text, registers get their index as val
+		virtual ParamInfo disassembler_parseParam(const char* start, const char* end, const char* instStart, const char* instEnd, uint32_t pcAddr) const = 0;
+		// resolves a parsed parameter to its current value (e.g. the content of a register)
+		virtual ParamInfo getParamInfo(const ParamInfo& param) const = 0;
 
 		virtual void draw_stateInfo() = 0;
 
@@ -166,7 +176,6 @@ namespace ABB {
 
 			const uint64_t* readCnt = nullptr;
 			const uint64_t* writeCnt = nullptr;
-			std::function<void()> resetRWAnalytics = nullptr;
 		};
 		virtual size_t numHexViewers() const = 0;
 		virtual Hex getHexViewer(size_t ind) = 0;
@@ -5,6 +5,7 @@
 #include <numeric>
 
 #include "imgui.h"
+#include "imgui/imguiExt.h"
 
 #include "StringUtils.h"
 #include "DataUtils.h"
@@ -13,8 +14,12 @@
 
 #include "ArduboyBackend.h"
 
+#define LU_MODULE "AnalyticsBackend"
+#define LU_CONTEXT (abb->logBackend.getLogContext())
+
 ABB::AnalyticsBackend::AnalyticsBackend(ArduboyBackend* abb, const char* winName, bool* open)
-: abb(abb), stackSizeBuf(100, 0), sleepCycsBuf(100, 0), frameTimeBuf(100), instHeatOrder(abb->mcu->consts.numInsts), winName(winName), open(open)
+: abb(abb), stackSizeBuf(100, 0), sleepCycsBuf(100, 0), frameTimeBuf(100), instHeatOrder(abb->mcu->consts.numInsts),
+fdiExportProfile((std::string(winName)+"_exportProfile").c_str()), winName(winName), open(open)
 {
     for(size_t i = 0; i<instHeatOrder.size(); i++){
         instHeatOrder[i] = i;
@@ -25,6 +30,7 @@ void ABB::AnalyticsBackend::update(){
     if(!(abb->mcu->debugger_isHalted() || !abb->mcu->flash_isProgramLoaded())){
         size_t SP = abb->mcu->analytics_getMaxSP();
         abb->mcu->analytics_resetMaxSP();
+        updateObservedCalls();
         stackSizeBuf.add((uint32_t)(abb->mcu->consts.dataspaceDataSize-1-SP));
 
         sleepCycsBuf.add((uint32_t)abb->mcu->analytics_getSleepSum());
@@ -32,6 +38,215 @@ void ABB::AnalyticsBackend::update(){
     }
 }
 
+void ABB::AnalyticsBackend::updateRamAccesses(){
+    // this is the only place the ram read/write counters get reset, so everything that happend since the last call gets counted exactly once
+    const uint64_t* reads = abb->mcu->analytics_getRamReads();
+    const uint64_t* writes = abb->mcu->analytics_getRamWrites();
+    if(reads && writes){
+        ramAccessHistory.addFrame(abb->symbolTable, reads, writes, abb->mcu->consts.dataspaceDataSize, !abb->mcu->debugger_isHalted());
+    }
+    abb->mcu->analytics_resetRamReadsWrites();
+}
+
+void ABB::AnalyticsBackend::updateObservedCalls(){
+    // the call stack is only tracked in debug mode
+    if(!abb->mcu->getDebugMode()){
+        lastCallStack.clear();
+        return;
+    }
+
+    // everything above the part of the call stack that didnt change since the last sample got called since then
+    size_t stackSize = abb->mcu->getStackPtr();
+    size_t commonLen = 0;
+    while(commonLen < stackSize && commonLen < lastCallStack.size() && lastCallStack[commonLen] == (Console::addrmcu_t)(abb->mcu->getStackTo(commonLen)*2))
+        commonLen++;
+
+    lastCallStack.resize(stackSize);
+    for(size_t i = commonLen; i<stackSize; i++){
+        Console::addrmcu_t addr = (Console::addrmcu_t)(abb->mcu->getStackTo(i)*2);
+        observedCalls[{(Console::addrmcu_t)(abb->mcu->getStackFrom(i)*2), addr}]++;
+        lastCallStack[i] = addr;
+    }
+}
+
+void ABB::AnalyticsBackend::analyzeHotLoops(){
+    hotLoops.clear();
+
+    const DebuggerBackend& dbg = abb->debuggerBackend;
+    hotLoopsSrcMix = dbg.selectedSrcMix;
+    if(hotLoopsSrcMix >= dbg.srcMixs.size())
+        return;
+    const DisasmFile& file = dbg.srcMixs[hotLoopsSrcMix].viewer.file;
+
+    // every backward branch closes a loop, branches to the same destination belong to the same loop
+    std::map<size_t, size_t> loopEnds; // [line of loop head] = line of last backward branch
+    for(const auto& branchRoot : file.branchRoots){
+        if(branchRoot.dest > branchRoot.start)
+            continue;
+        auto res = loopEnds.insert({branchRoot.destLine, branchRoot.startLine});
+        if(!res.second && res.first->second < branchRoot.startLine)
+            res.first->second = branchRoot.startLine;
+    }
+
+    for(const auto& loopEnd : loopEnds){
+        HotLoop loop;
+        loop.headLine = loopEnd.first;
+        loop.endLine = loopEnd.second;
+        loop.headAddr = file.addrs[loop.headLine];
+        loop.endAddr = file.addrs[loop.endLine];
+        loop.iterations = abb->mcu->analytics_getPCHeat(loop.headAddr/2);
+        loop.cycles = 0;
+
+        for(size_t l = loop.headLine; l <= loop.endLine; l++){
+            Console::addrmcu_t addr = file.addrs[l];
+            if(!file.isLineProgram[l] || !DisasmFile::addrIsActualAddr(addr) || (size_t)addr/2 >= abb->mcu->programSize())
+                continue;
+
+            loop.cycles += abb->mcu->analytics_getPCCycles(addr/2);
+        }
+
+        if(loop.cycles > 0)
+            hotLoops.push_back(loop);
+    }
+
+    std::stable_sort(hotLoops.begin(), hotLoops.end(), [](const HotLoop& a, const HotLoop& b) {
+        return a.cycles > b.cycles;
+    });
+}
+
+static void drawRightAlignedNum(uint64_t num) {
+    std::string s = StringUtils::addThousandsSeperator(std::to_string(num).c_str());
+    ImVec2 size = ImGui::GetContentRegionAvail();
+    ImVec2 textSize = ImGui::CalcTextSize(s.c_str());
+    ImGui::SetCursorPosX(ImGui::GetCursorPosX()+(size.x-textSize.x));
+    ImGui::TextUnformatted(s.c_str());
+}
+
+void ABB::AnalyticsBackend::drawHotVariables(){
+    ImGui::SliderInt("Time Window", &hotVarsWindowSecs, 1, (int)(RamAccessHistory::numBuckets*RamAccessHistory::framesPerBucket/60), "%d s");
+    size_t numBucketsBack = std::max((size_t)hotVarsWindowSecs*60/RamAccessHistory::framesPerBucket, (size_t)1);
+
+    hotVarsOrder.clear();
+    for(size_t i = 0; i<ramAccessHistory.numRows(); i++){
+        auto sum = ramAccessHistory.sumRow(i, numBucketsBack);
+        if(sum.first + sum.second > 0)
+            hotVarsOrder.push_back({i, sum.first + sum.second});
+    }
+    std::stable_sort(hotVarsOrder.begin(), hotVarsOrder.end(), [](const std::pair<size_t, uint64_t>& a, const std::pair<size_t, uint64_t>& b) {
+        return a.second > b.second;
+    });
+
+    constexpr ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable;
+    if(ImGui::BeginTable("hotVarsTable", 4, flags, {0, 300})){
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Symbol");
+        ImGui::TableSetupColumn("Reads");
+        ImGui::TableSetupColumn("Writes");
+        ImGui::TableSetupColumn("History");
+        ImGui::TableHeadersRow();
+
+        ImGuiListClipper clipper;
+        clipper.Begin((int)hotVarsOrder.size());
+        while(clipper.Step()){
+            for(int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++){
+                size_t row = hotVarsOrder[i].first;
+                auto sum = ramAccessHistory.sumRow(row, numBucketsBack);
+
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                if(row < ramAccessHistory.symbolIds.size()){
+                    const EmuUtils::SymbolTable::Symbol* symbol = abb->symbolTable.getSymbolById(ramAccessHistory.symbolIds[row]);
+                    if(symbol) {
+                        ImGuiExt::TextColored(SymbolBackend::getSymbolColor(symbol->id), symbol->demangled.c_str());
+                        if(ImGui::IsItemHovered()){
+                            ImGui::BeginTooltip();
+                            SymbolBackend::drawSymbol(symbol, symbol->value, abb->mcu->dataspace_getData());
+                            ImGui::EndTooltip();
+                        }
+                    }
+                }else{
+                    ImGui::TextDisabled("<no symbol>");
+                }
+
+                ImGui::TableNextColumn();
+                drawRightAlignedNum(sum.first);
+                ImGui::TableNextColumn();
+                drawRightAlignedNum(sum.second);
+
+                ImGui::TableNextColumn();
+                std::pair<const RamAccessHistory*, size_t> plotData = {&ramAccessHistory, row};
+                ImGui::PushID((int)row);
+                ImGui::PlotLines("##hist", &getRamAccessHistVal, &plotData, (int)RamAccessHistory::numBuckets, 0, NULL, 0, FLT_MAX, {-1, ImGui::GetTextLineHeight()});
+                ImGui::PopID();
+            }
+        }
+        ImGui::EndTable();
+    }
+}
+
+void ABB::AnalyticsBackend::drawHotLoops(){
+    DebuggerBackend& dbg = abb->debuggerBackend;
+    if(dbg.selectedSrcMix >= dbg.srcMixs.size()){
+        ImGui::TextDisabled("Load or generate a srcMix in the Debugger to find loops");
+        return;
+    }
+
+    if(ImGui::Button("Analyze")){
+        analyzeHotLoops();
+    }
+    ImGui::SameLine();
+    ImGui::TextDisabled("(?)");
+    if(ImGui::IsItemHovered()){
+        ImGui::SetTooltip("Loops are found via backward branches in the selected srcMix and ranked by\nthe cycles spent in them since the PC heat was last reset. Click a loop to jump to it");
+    }
+
+    if(hotLoopsSrcMix >= dbg.srcMixs.size())
+        return;
+    const DisasmFile& file = dbg.srcMixs[hotLoopsSrcMix].viewer.file;
+
+    constexpr ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable;
+    if(ImGui::BeginTable("hotLoopsTable", 4, flags, {0, 300})){
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Loop");
+        ImGui::TableSetupColumn("Cycles");
+        ImGui::TableSetupColumn("Iterations");
+        ImGui::TableSetupColumn("Cycles/Iteration");
+        ImGui::TableHeadersRow();
+
+        ImGuiListClipper clipper;
+        clipper.Begin((int)hotLoops.size());
+        while(clipper.Step()){
+            for(int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++){
+                const HotLoop& loop = hotLoops[i];
+
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                char buf[64];
+                snprintf(buf, sizeof(buf), "%04" MCU_PRIxADDR " - %04" MCU_PRIxADDR "##%d", loop.headAddr, loop.endAddr, i);
+                if(ImGui::Selectable(buf, false, ImGuiSelectableFlags_SpanAllColumns) && loop.endLine < file.getNumLines()){
+                    dbg.srcMixs[hotLoopsSrcMix].viewer.scrollToLine(loop.headLine, true);
+                    ImGui::SetWindowFocus(dbg.getWinName());
+                }
+                if(abb->symbolTable.hasSymbols()){
+                    const EmuUtils::SymbolTable::Symbol* symbol = abb->symbolIndex.getSymbolByValue(loop.headAddr, abb->symbolTable.getSymbolsRom());
+                    if(symbol){
+                        ImGui::SameLine();
+                        ImGuiExt::TextColored(SymbolBackend::getSymbolColor(symbol->id), symbol->demangled.c_str());
+                    }
+                }
+
+                ImGui::TableNextColumn();
+                drawRightAlignedNum(loop.cycles);
+                ImGui::TableNextColumn();
+                drawRightAlignedNum(loop.iterations);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.2f", loop.iterations > 0 ? (double)loop.cycles / loop.iterations : 0.0);
+            }
+        }
+        ImGui::EndTable();
+    }
+}
+
 void ABB::AnalyticsBackend::draw(){
     if(ImGui::Begin(winName.c_str(), open)){
         winFocused = ImGui::IsWindowFocused();
@@ -72,6 +287,14 @@ void ABB::AnalyticsBackend::draw(){
 
         if(ImGui::Button("reset PC heat")){
             abb->mcu->analytics_resetPCHeat();
+            observedCalls.clear();
+        }
+        ImGui::SameLine();
+        if(ImGui::Button("Export Callgrind Profile")){
+            fdiExportProfile.OpenDialog(ImGuiFDMode_SaveFile, ".");
+        }
+        if(ImGui::IsItemHovered()){
+            ImGui::SetTooltip("Export PC heat, cycles and calls in the callgrind format (for kcachegrind/qcachegrind)");
         }
 
         if(ImGui::TreeNode("Inst heat")){
@@ -93,33 +316,68 @@ void ABB::AnalyticsBackend::draw(){
                     ImGui::TextUnformatted(abb->mcu->getInstName(instInd));
 
                     ImGui::TableNextColumn();
-                    {
-                        std::string s = StringUtils::addThousandsSeperator(std::to_string(abb->mcu->analytics_getInstHeat(instInd)).c_str());
-                        ImVec2 size = ImGui::GetContentRegionAvail();
-                        ImVec2 textSize = ImGui::CalcTextSize(s.c_str());
-                        ImGui::SetCursorPosX(ImGui::GetCursorPosX()+(size.x-textSize.x));
-                        ImGui::TextUnformatted(s.c_str());
-                    }
+                    drawRightAlignedNum(abb->mcu->analytics_getInstHeat(instInd));
                 }
                 ImGui::EndTable();
             }
             ImGui::TreePop();
         }
+
+        if(ImGui::TreeNode("Hot loops")){
+            drawHotLoops();
+            ImGui::TreePop();
+        }
+
+        if(ImGui::TreeNode("Hot variables")){
+            drawHotVariables();
+            ImGui::TreePop();
+        }
     }
     else {
         winFocused = false;
     }
     ImGui::End();
+
+    fdiExportProfile.DrawDialog([](void* userData){
+        DU_ASSERT(userData != nullptr);
+        ((AnalyticsBackend*)userData)->exportCallgrindProfile(ImGuiFD::GetSelectionPathString(0));
+    }, this);
 }
 
 const char* ABB::AnalyticsBackend::getWinName() const {
     return winName.c_str();
 }
 
+bool ABB::AnalyticsBackend::exportCallgrindProfile(const char* path) {
+    const DisasmFile* srcMix = nullptr;
+    const char* srcMixName = nullptr;
+    const DebuggerBackend& dbg = abb->debuggerBackend;
+    if(dbg.selectedSrcMix < dbg.srcMixs.size()){
+        srcMix = &dbg.srcMixs[dbg.selectedSrcMix].viewer.file;
+        srcMixName = dbg.srcMixs[dbg.selectedSrcMix].viewer.title.c_str();
+    }
+
+    std::string profile = utils::Callgrind::genProfile(abb->mcu.get(), &abb->symbolTable, srcMix, srcMixName, &observedCalls);
+    try {
+        StringUtils::writeBytesToFile((const uint8_t*)profile.c_str(), profile.size(), path);
+    }
+    catch (const std::runtime_error& e) {
+        LU_LOGF(LogUtils::LogLevel_Error, "Could not write profile to \"%s\": %s", path, e.what());
+        return false;
+    }
+
+    LU_LOGF(LogUtils::LogLevel_Output, "Exported callgrind profile to \"%s\"", path);
+    return true;
+}
+
 void ABB::AnalyticsBackend::reset() {
     stackSizeBuf.clear();
     sleepCycsBuf.clear();
     frameTimeBuf.clear();
+    ramAccessHistory.reset();
+    lastCallStack.clear();
+    hotLoops.clear();
+    observedCalls.clear();
 }
 
 
@@ -145,6 +403,17 @@ float ABB::AnalyticsBackend::getFrameTimeBuf(void* data, int ind){
     return frameTimeBuf->get(ind);
 }
 
+float ABB::AnalyticsBackend::getRamAccessHistVal(void* data, int ind){
+    const auto* plotData = (const std::pair<const RamAccessHistory*, size_t>*)data;
+    const RamAccessHistory* hist = plotData->first;
+    size_t age = RamAccessHistory::numBuckets - 1 - ind;
+    if(hist->buckets.size() == 0 || age >= hist->bucketsFilled){
+        return 0;
+    }
+    const RamAccessHistory::Counts& cnt = hist->getBucket(age)[plotData->second];
+    return (float)cnt.reads + (float)cnt.writes;
+}
+
 bool ABB::AnalyticsBackend::isWinFocused() const {
     return winFocused;
 }
@@ -160,9 +429,116 @@ size_t ABB::AnalyticsBackend::sizeBytes() const {
     sum += sizeof(winFocused);
 
     sum += DataUtils::approxSizeOf(instHeatOrder);
+    sum += ramAccessHistory.sizeBytes();
+    sum += sizeof(hotVarsWindowSecs);
+    sum += DataUtils::approxSizeOf(hotVarsOrder);
+    sum += DataUtils::approxSizeOf(lastCallStack);
+    sum += sizeof(hotLoops) + hotLoops.capacity()*sizeof(HotLoop);
+    sum += sizeof(hotLoopsSrcMix);
+    sum += DataUtils::approxSizeOf(observedCalls);
+    sum += fdiExportProfile.sizeBytes();
 
     sum += DataUtils::approxSizeOf(winName);
     sum += sizeof(open);
 
     return sum;
 }
+
+
+
+size_t ABB::AnalyticsBackend::RamAccessHistory::numRows() const {
+    return symbolIds.size() + 1;
+}
+const ABB::AnalyticsBackend::RamAccessHistory::Counts* ABB::AnalyticsBackend::RamAccessHistory::getBucket(size_t age) const {
+    DU_ASSERT(age < numBuckets);
+    return &buckets[((bucketHead + numBuckets - age) % numBuckets) * numRows()];
+}
+std::pair<uint64_t, uint64_t> ABB::AnalyticsBackend::RamAccessHistory::sumRow(size_t row, size_t numBucketsBack) const {
+    std::pair<uint64_t, uint64_t> sum = {0,0};
+    if(buckets.size() == 0)
+        return sum;
+    numBucketsBack = std::min(numBucketsBack, bucketsFilled);
+    for(size_t i = 0; i<numBucketsBack; i++){
+        const Counts& cnt = getBucket(i)[row];
+        sum.first += cnt.reads;
+        sum.second += cnt.writes;
+    }
+    return sum;
+}
+
+void ABB::AnalyticsBackend::RamAccessHistory::reset() {
+    buckets.assign(numBuckets * numRows(), Counts());
+    bucketHead = 0;
+    bucketsFilled = 1;
+    framesInBucket = 0;
+}
+void ABB::AnalyticsBackend::RamAccessHistory::syncSymbols(const EmuUtils::SymbolTable& table) {
+    const auto& list = table.getSymbolsRam();
+
+    bool same = list.size() == symbolIds.size() && buckets.size() > 0;
+    for(size_t i = 0; same && i<list.size(); i++){
+        if(table.getSymbol(list, i)->id != symbolIds[i])
+            same = false;
+    }
+    if(same)
+        return;
+
+    symbolIds.resize(list.size());
+    for(size_t i = 0; i<list.size(); i++){
+        symbolIds[i] = table.getSymbol(list, i)->id;
+    }
+    reset();
+}
+void ABB::AnalyticsBackend::RamAccessHistory::addFrame(const EmuUtils::SymbolTable& table, const uint64_t* reads, const uint64_t* writes, size_t len, bool advance) {
+    syncSymbols(table);
+
+    const auto& list = table.getSymbolsRam();
+    Counts* bucket = &buckets[bucketHead * numRows()];
+    Counts& noSymbol = bucket[symbolIds.size()];
+
+    // list is sorted by address, so a single pass over the data is enough
+    size_t addr = 0;
+    for(size_t i = 0; i<list.size(); i++){
+        const auto* symbol = table.getSymbol(list, i);
+        size_t start = std::min((size_t)symbol->value, len);
+        size_t end = std::min((size_t)symbol->addrEnd(), len);
+
+        for(; addr < start; addr++){
+            noSymbol.reads += (uint32_t)reads[addr];
+            noSymbol.writes += (uint32_t)writes[addr];
+        }
+
+        uint64_t r = 0, w = 0;
+        for(size_t a = start; a < end; a++){
+            r += reads[a];
+            w += writes[a];
+        }
+        bucket[i].reads += (uint32_t)r;
+        bucket[i].writes += (uint32_t)w;
+
+        addr = std::max(addr, end);
+    }
+    for(; addr < len; addr++){
+        noSymbol.reads += (uint32_t)reads[addr];
+        noSymbol.writes += (uint32_t)writes[addr];
+    }
+
+    if(advance && ++framesInBucket >= framesPerBucket){
+        framesInBucket = 0;
+        bucketHead = (bucketHead + 1) % numBuckets;
+        bucketsFilled = std::min(bucketsFilled + 1, numBuckets);
+        std::fill(buckets.begin() + bucketHead*numRows(), buckets.begin() + (bucketHead+1)*numRows(), Counts());
+    }
+}
+
+size_t ABB::AnalyticsBackend::RamAccessHistory::sizeBytes() const {
+    size_t sum = 0;
+
+    sum += DataUtils::approxSizeOf(symbolIds);
+    sum += sizeof(buckets) + buckets.capacity()*sizeof(Counts);
+    sum += sizeof(bucketHead);
+    sum += sizeof(bucketsFilled);
+    sum += sizeof(framesInBucket);
+
+    return sum;
+}
\ No newline at end of file
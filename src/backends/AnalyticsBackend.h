@@ -4,7 +4,12 @@
 #include "../Console.h"
 #include "SymbolBackend.h"
 
+#include <map>
+
 #include "comps/ringBuffer.h"
+#include "ImGuiFD.h"
+
+#include "../utils/callgrindExport.h"
 
 namespace ABB{
     class ArduboyBackend;
@@ -22,6 +27,61 @@ namespace ABB{
         bool winFocused = false;
 
         std::vector<size_t> instHeatOrder;
+
+        // ram accesses summed up per ram symbol, one bucket covers multiple frames so that memory stays bounded
+        struct RamAccessHistory {
+            static constexpr size_t framesPerBucket = 10;
+            static constexpr size_t numBuckets = 60; // ~10s at 60fps
+
+            struct Counts {
+                uint32_t reads = 0;
+                uint32_t writes = 0;
+            };
+
+            std::vector<uint32_t> symbolIds; // id of the symbol of every row, there is one extra row for bytes without a symbol
+            std::vector<Counts> buckets; // ring of numBuckets buckets, each one containing numRows() Counts
+            size_t bucketHead = 0; // bucket that is currently being filled
+            size_t bucketsFilled = 1;
+            size_t framesInBucket = 0;
+
+            size_t numRows() const;
+            const Counts* getBucket(size_t age) const; // age 0 is the bucket currently being filled
+            std::pair<uint64_t, uint64_t> sumRow(size_t row, size_t numBucketsBack) const;
+
+            void reset();
+            void syncSymbols(const EmuUtils::SymbolTable& table);
+            void addFrame(const EmuUtils::SymbolTable& table, const uint64_t* reads, const uint64_t* writes, size_t len, bool advance);
+
+            size_t sizeBytes() const;
+        };
+        RamAccessHistory ramAccessHistory;
+
+        std::vector<Console::addrmcu_t> lastCallStack; // call stack (destinations) at the end of the last frame
+        // call edges seen in the per frame samples of the call stack. Not call counts, only used to split up the (exact) number of
+        // calls of an indirect call site (from its PC heat) between its destinations
+        utils::Callgrind::CallEdgeMap observedCalls;
+
+        ImGuiFD::FDInstance fdiExportProfile;
+
+        void updateObservedCalls(); // samples the call stack, called once per frame
+
+        struct HotLoop {
+            Console::addrmcu_t headAddr; // destination of the backward branch(es)
+            Console::addrmcu_t endAddr;  // last backward branch to headAddr
+            size_t headLine;
+            size_t endLine;
+            uint64_t iterations;
+            uint64_t cycles;
+        };
+        std::vector<HotLoop> hotLoops; // sorted by cycles
+        size_t hotLoopsSrcMix = -1; // index of the srcMix the loops were found in
+
+        void analyzeHotLoops();
+        void drawHotLoops();
+        int hotVarsWindowSecs = 10;
+        std::vector<std::pair<size_t, uint64_t>> hotVarsOrder;
+
+        void drawHotVariables();
     public:
         std::string winName;
         bool* open;
@@ -29,14 +89,18 @@ namespace ABB{
         AnalyticsBackend(ArduboyBackend* abb, const char* winName, bool* open);
 
         void update();
+        void updateRamAccesses();
         void draw();
 
         const char* getWinName() const;
 
+        bool exportCallgrindProfile(const char* path);
+
         void reset();
         static float getStackSizeBuf(void* data, int ind);
         static float getSleepCycsBuf(void* data, int ind);
         static float getFrameTimeBuf(void* data, int ind);
+        static float getRamAccessHistVal(void* data, int ind);
 
         bool isWinFocused() const;
 
@@ -2,6 +2,8 @@
 
 #include <exception>
 #include <chrono>
+#include <mutex>
+#include <cstring>
 
 #include "imgui.h"
 #include "imgui_internal.h"
@@ -11,12 +13,13 @@
 #include "../ArduEmu.h"
 
 #include "imgui/imguiExt.h"
+#include "../utils/hexLoader.h"
 
 #define LU_MODULE "ArduboyBackend"
 #define LU_CONTEXT logBackend.getLogContext()
 
 ABB::ArduboyBackend::ArduboyBackend(const char* n, size_t id, std::unique_ptr<Console>&& mcu_) :
-	mcu(std::move(mcu_)),
+	mcu(std::move(mcu_)), symbolTable(getDeviceSymbols().table), symbolIndex(&symbolTable),
 	name(n), devWinName(std::string(n) + "devtools"), 
 	logBackend      (mcu.get(), (name + " - " ADD_ICON(ICON_FA_LIST)        "Log").c_str(), &devToolsOpen),
 	displayBackend  (mcu.get(), (name + " - " ADD_ICON(ICON_FA_TV)          "Display").c_str()),
@@ -28,18 +31,14 @@ ABB::ArduboyBackend::ArduboyBackend(const char* n, size_t id, std::unique_ptr<Co
 	soundBackend    (           (name + " - " ADD_ICON(ICON_FA_VOLUME_HIGH) "Sound"    ).c_str(), &devToolsOpen),
 	id(id)
 {
-	try {
-		symbolTable.loadDeviceSymbolDumpFile("resources/device/regSymbs.txt");
-	}
-	catch (const std::runtime_error& e) {
-		LU_LOGF(LogUtils::LogLevel_Error, "Error loading device symbols: %s", e.what());
-	}
+	if (getDeviceSymbols().error.size() > 0)
+		LU_LOGF(LogUtils::LogLevel_Error, "Error loading device symbols: %s", getDeviceSymbols().error.c_str());
 
 	//ImGui::DockBuilderSplitNode(ImGuiID(ImGui::GetID(devWinName.c_str())), ImGuiDir_Left, 0.5, );
 }
 
 ABB::ArduboyBackend::ArduboyBackend(const ArduboyBackend& src):
-mcu(src.mcu->clone()),
+mcu(src.mcu->clone()), symbolIndex(&symbolTable),
 name(src.name), devWinName(src.devWinName),
 logBackend(src.logBackend), displayBackend(src.displayBackend), debuggerBackend(src.debuggerBackend),
 mcuInfoBackend(src.mcuInfoBackend), analyticsBackend(src.analyticsBackend), compilerBackend(src.compilerBackend), symbolBackend(src.symbolBackend), soundBackend(src.soundBackend),
@@ -63,6 +62,20 @@ ABB::ArduboyBackend& ABB::ArduboyBackend::operator=(const ArduboyBackend& src){
 	return *this;
 }
 
+const ABB::ArduboyBackend::DeviceSymbols& ABB::ArduboyBackend::getDeviceSymbols() {
+	static const DeviceSymbols deviceSymbols = [] {
+		DeviceSymbols ret;
+		try {
+			ret.table.loadDeviceSymbolDumpFile("resources/device/regSymbs.txt");
+		}
+		catch (const std::runtime_error& e) {
+			ret.error = e.what();
+		}
+		return ret;
+	}();
+	return deviceSymbols;
+}
+
 void ABB::ArduboyBackend::setMcu() {
 	logBackend.mcu = mcu.get();
 	displayBackend.mcu = mcu.get();
@@ -85,6 +98,8 @@ void ABB::ArduboyBackend::exitFullscreen(){
 }
 
 void ABB::ArduboyBackend::update() {
+	logBackend.update(); // also needs to run without a program, otherwise load errors would never show up
+
 	if(!mcu->flash_isProgramLoaded())
 		return;
 
@@ -108,6 +123,8 @@ void ABB::ArduboyBackend::update() {
 		mcu->setButtons(false, false, false, false, false, false);
 	}
 
+	analyticsBackend.updateRamAccesses();
+
 	auto start = std::chrono::high_resolution_clock::now();
 	mcu->newFrame();
 	auto end = std::chrono::high_resolution_clock::now();
@@ -252,25 +269,17 @@ bool ABB::ArduboyBackend::loadFile(const char* path) {
 	const char* ext = StringUtils::getFileExtension(path);
 
 	if (std::strcmp(ext, "hex") == 0) {
-		std::string content;
-		try {
-			content = StringUtils::loadFileIntoString(path);
-		}
-		catch (const std::runtime_error& e) {
-			LU_LOGF(LogUtils::LogLevel_Error, "Couldn't load File: %s", e.what());
-			return false;
-		}
-
-		std::vector<uint8_t> hex;
+		std::vector<uint8_t> hex(mcu->flash_size(), 0);
+		size_t len;
 		try {
-			hex = StringUtils::parseHexFileStr(content.c_str(), content.c_str() + content.size());
+			len = utils::IntelHex::decodeFile(path, hex.data(), hex.size());
 		}
 		catch (const std::runtime_error& e) {
-			LU_LOGF(LogUtils::LogLevel_Error, "Parsing hex failed: %s", e.what());
+			LU_LOGF(LogUtils::LogLevel_Error, "Loading hex failed: %s", e.what());
 			return false;
 		}
 
-		return mcu->flash_loadFromMemory(hex.size() ? & hex[0] : 0, hex.size());
+		return mcu->flash_loadFromMemory(len ? hex.data() : nullptr, len);
 	}
 	else if (std::strcmp(ext, "bin") == 0) {
 		std::vector<uint8_t> data;
@@ -315,15 +324,101 @@ bool ABB::ArduboyBackend::loadFromELFFile(const char* path) {
 
 	return loadFromELF(content.size() ? &content[0] : 0, content.size());
 }
+// MurmurHash3 x64 128
+static uint64_t rotl64(uint64_t x, int r) {
+	return (x << r) | (x >> (64 - r));
+}
+static uint64_t fmix64(uint64_t k) {
+	k ^= k >> 33;
+	k *= 0xFF51AFD7ED558CCDull;
+	k ^= k >> 33;
+	k *= 0xC4CEB9FE1A85EC53ull;
+	k ^= k >> 33;
+	return k;
+}
+static void hashContent(const uint8_t* data, size_t len, uint64_t out[2]) {
+	constexpr uint64_t c1 = 0x87C37B91114253D5ull;
+	constexpr uint64_t c2 = 0x4CF5AD432745937Full;
+	uint64_t h1 = 0, h2 = 0;
+
+	size_t i = 0;
+	for (; i + 16 <= len; i += 16) {
+		uint64_t k1, k2;
+		std::memcpy(&k1, data + i, 8);
+		std::memcpy(&k2, data + i + 8, 8);
+
+		k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+		h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52DCE729;
+		k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+		h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495AB5;
+	}
+
+	uint8_t tail[16] = {0};
+	if (len > i)
+		std::memcpy(tail, data + i, len - i);
+	uint64_t k1, k2;
+	std::memcpy(&k1, tail, 8);
+	std::memcpy(&k2, tail + 8, 8);
+	if (len - i > 8) {
+		k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+	}
+	if (len - i > 0) {
+		k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+	}
+
+	h1 ^= len; h2 ^= len;
+	h1 += h2; h2 += h1;
+	h1 = fmix64(h1); h2 = fmix64(h2);
+	h1 += h2; h2 += h1;
+	out[0] = h1;
+	out[1] = h2;
+}
+
+std::shared_ptr<const ABB::ArduboyBackend::ParsedELF> ABB::ArduboyBackend::getParsedELF(const uint8_t* data, size_t dataLen) {
+	static std::mutex mutex;
+	static std::vector<std::shared_ptr<const ParsedELF>> cache; // most recently used last
+
+	uint64_t hash[2];
+	hashContent(data, dataLen, hash);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (size_t i = 0; i < cache.size(); i++) {
+			const auto& entry = cache[i];
+			if (entry->hash[0] == hash[0] && entry->hash[1] == hash[1] && entry->dataLen == dataLen) {
+				auto ret = entry;
+				cache.erase(cache.begin() + i);
+				cache.push_back(ret);
+				return ret;
+			}
+		}
+	}
+
+	// parsing happens outside of the lock, so different elfs can be parsed in parallel
+	auto parsed = std::make_shared<ParsedELF>();
+	parsed->hash[0] = hash[0];
+	parsed->hash[1] = hash[1];
+	parsed->dataLen = dataLen;
+	parsed->elf = std::make_shared<const EmuUtils::ELF::ELFFile>(EmuUtils::ELF::parseELFFile(data, dataLen));
+	parsed->rom = EmuUtils::ELF::getProgramData(*parsed->elf);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	cache.push_back(parsed);
+	if (cache.size() > parsedELFCacheSize)
+		cache.erase(cache.begin());
+	return parsed;
+}
+
 bool ABB::ArduboyBackend::loadFromELF(const uint8_t* data, size_t dataLen) {
 	try {
-		elfFile = std::make_unique<EmuUtils::ELF::ELFFile>(EmuUtils::ELF::parseELFFile(data, dataLen));
+		std::shared_ptr<const ParsedELF> parsed = getParsedELF(data, dataLen);
 
-		symbolTable.loadFromELF(*elfFile);
+		elfFile = parsed->elf;
 
-		auto romData = EmuUtils::ELF::getProgramData(*elfFile);
+		// merged into the existing table, so symbols that were added by hand or loaded from dumps stay
+		symbolTable.loadFromELF(*elfFile);
+		symbolIndex.invalidate();
 
-		return mcu->flash_loadFromMemory(&romData[0], romData.size());
+		return mcu->flash_loadFromMemory(parsed->rom.data(), parsed->rom.size());
 	}
 	catch (const std::runtime_error& e) {
 		LU_LOGF(LogUtils::LogLevel_Error, "Couldn't load ELF File: %s", e.what());
@@ -445,6 +540,7 @@ size_t ABB::ArduboyBackend::sizeBytes() const {
 	size_t sum = 0;
 
 	sum += mcu->sizeBytes();
+	sum += symbolIndex.sizeBytes();
 
 	sum += DataUtils::approxSizeOf(name);
 	sum += DataUtils::approxSizeOf(devWinName);
@@ -7,6 +7,7 @@
 
 #include "../Console.h"
 #include "comps/StringTable.h"
+#include "../utils/symbolIndex.h"
 
 #include "DisplayBackend.h"
 #include "DebuggerBackend.h"
@@ -23,8 +24,9 @@ namespace ABB {
 
 		std::unique_ptr<Console> mcu;
 		EmuUtils::SymbolTable symbolTable;
+		utils::SymbolIndex symbolIndex; // address lookups into symbolTable for all views, needs to be invalidated when the symbols change
 
-		std::unique_ptr<EmuUtils::ELF::ELFFile> elfFile = nullptr;
+		std::shared_ptr<const EmuUtils::ELF::ELFFile> elfFile = nullptr; // might be shared with other instances that loaded the same elf
 
 		std::string name;
 		std::string devWinName;
@@ -56,6 +58,26 @@ namespace ABB {
 		void update();
 
 		void setMcu();
+
+		// the device (register) symbols are the same for every instance, so they only get parsed once per process
+		struct DeviceSymbols {
+			EmuUtils::SymbolTable table;
+			std::string error; // set if loading failed
+		};
+		static const DeviceSymbols& getDeviceSymbols();
+
+		// everything loadFromELF gets out of an elf, cached by content so loading the same elf again is cheap.
+		// Entries are identified by a 128 bit hash + the size, so the raw content doesnt need to be kept around.
+		// The symbol table is deliberately not cached: the elf symbols get merged into each instance's own table
+		// (which might contain symbols added by hand or loaded from dumps)
+		struct ParsedELF {
+			uint64_t hash[2];
+			size_t dataLen;
+			std::shared_ptr<const EmuUtils::ELF::ELFFile> elf;
+			std::vector<uint8_t> rom;
+		};
+		static constexpr size_t parsedELFCacheSize = 8;
+		static std::shared_ptr<const ParsedELF> getParsedELF(const uint8_t* data, size_t dataLen); // throws std::runtime_error
 	public:
 
 		ArduboyBackend(const char* n, size_t id, std::unique_ptr<Console>&& mcu);
@@ -1,6 +1,10 @@
 #include "DebuggerBackend.h"
 
 #include <inttypes.h> // for PRIx64 etc.
+#include <algorithm>
+#if !defined(__EMSCRIPTEN__)
+#include <thread>
+#endif
 
 #define IMGUI_DEFINE_MATH_OPERATORS 1
 #include "imgui.h"
@@ -17,6 +21,8 @@
 #include "StringUtils.h"
 #include "DataUtilsSize.h"
 
+#include "../bintools/bintools.h"
+
 #define LU_MODULE "DebuggerBackend"
 #define LU_CONTEXT abb->logBackend.getLogContext()
 
@@ -227,10 +233,29 @@ bool ABB::DebuggerBackend::drawLoadGenerateButtons() {
 		}
 	}
 
+	ImGui::SameLine();
+	if (!abb->elfFile)
+		ImGui::BeginDisabled();
+
+	if (ImGui::Button("Generate from ELF")) {
+		pressed = true;
+		generateSrcFromELF();
+	}
+
+	if (!abb->elfFile) {
+		ImGui::EndDisabled();
+		if (ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled)) {
+			ImGui::SetTooltip("Needs a loaded ELF file with debug info");
+		}
+	}
+
 	return pressed;
 }
 
 void ABB::DebuggerBackend::draw() {
+	updateDisasmJobs();
+	applyFlashEdits();
+
 	if (ImGui::Begin(winName.c_str(),open)) {
 		winFocused = ImGui::IsWindowFocused();
 
@@ -276,6 +301,8 @@ void ABB::DebuggerBackend::draw() {
 					}
 
 					if (!open) {
+						if (srcMixs[i].job)
+							srcMixs[i].job->ctrl.cancel = true;
 						srcMixs.erase(srcMixs.begin() + i);
 						if (selectedSrcMix >= srcMixs.size())
 							selectedSrcMix = srcMixs.size() - 1;
@@ -289,16 +316,30 @@ void ABB::DebuggerBackend::draw() {
 			}
 
 			if(srcMixs.size() > 0){
-				if(srcMixs[selectedSrcMix].selfDisassembled){
+				SrcMix& srcMix = srcMixs[selectedSrcMix];
+				if (srcMix.job) {
+					const char* cancelStr = "Cancel";
+					const float cancelWidth = ImGui::CalcTextSize(cancelStr).x + ImGui::GetStyle().FramePadding.x * 2;
+
+					char buf[64];
+					const float progress = srcMix.job->ctrl.progress;
+					std::snprintf(buf, sizeof(buf), "%s... %.0f%%", srcMix.job->file ? "Loading" : (srcMix.job->elf ? "Generating" : "Disassembling"), progress * 100);
+					ImGui::ProgressBar(progress, { -(cancelWidth + ImGui::GetStyle().ItemSpacing.x), 0 }, buf);
+					ImGui::SameLine();
+					if (ImGui::Button(cancelStr))
+						srcMix.job->ctrl.cancel = true;
+				}
+				else if(srcMix.selfDisassembled){
 					ImGui::AlignTextToFramePadding();
-					ImGui::Text("Disassembled %" CU_PRIuSIZE " lines", srcMixs[selectedSrcMix].viewer.numOfDisasmLines());
+					ImGui::Text("Disassembled %" CU_PRIuSIZE " lines", srcMix.viewer.numOfDisasmLines());
 					ImGui::SameLine();
 					if(ImGui::Button("Update with analytics data")) {
-						std::string disasmed = disasmProg();
-						srcMixs[selectedSrcMix].viewer.loadSrc(abb->mcu.get(), disasmed.c_str(), disasmed.c_str() + disasmed.size());
+						srcMix.job = startDisasmJob();
 					}
 				}
-				srcMixs[selectedSrcMix].viewer.drawFile(abb->mcu->getPCAddr(), abb->mcu.get(), &abb->symbolTable);
+
+				if (!srcMix.viewer.file.isEmpty() || !srcMix.job)
+					srcMix.viewer.drawFile(abb->mcu->getPCAddr(), abb->mcu.get(), &abb->symbolTable, &abb->symbolIndex);
 			}
 			else{
 				ImGui::TextUnformatted("Couldnt generate disassembly, load or generate?");
@@ -340,16 +381,39 @@ ABB::utils::AsmViewer& ABB::DebuggerBackend::addSrcMix(bool selfDisassembled) {
 	return srcMix;
 }
 
-std::string ABB::DebuggerBackend::disasmProg() {
-	std::vector<std::pair<uint32_t, std::string>> srcLines;
+std::shared_ptr<ABB::DebuggerBackend::DisasmJob> ABB::DebuggerBackend::createDisasmJob() {
+	auto job = std::make_shared<DisasmJob>();
+	job->startTime = std::chrono::high_resolution_clock::now();
+
+	job->cons = abb->mcu->clone();
+	job->cons->setLogCallB(DisasmJob::logRecive, job.get());
+	job->ctrl.logContext = { DisasmJob::logRecive, job.get() };
+	return job;
+}
+void ABB::DebuggerBackend::launchDisasmJob(const std::shared_ptr<DisasmJob>& job) {
+#if defined(__EMSCRIPTEN__)
+	job->run(); // no threads available
+#else
+	std::thread([job] {
+		job->run();
+	}).detach();
+#endif
+}
+
+std::shared_ptr<ABB::DebuggerBackend::DisasmJob> ABB::DebuggerBackend::startDisasmJob() {
+	auto job = createDisasmJob();
+	job->ctrl.progressFrom = 0.5f; // the first half is the disassembler itself, which cant report its progress
+
+	// everything that touches state shared with the ui is gathered here, the worker only uses the job
 	if (abb->elfFile) {
-		srcLines = EmuUtils::ELF::genSourceSnippets(*abb->elfFile);
+		job->srcLines = EmuUtils::ELF::genSourceSnippets(*abb->elfFile);
 	}
-	const std::vector<std::pair<uint32_t, std::string>> funcSymbs = abb->symbolTable.getFuncSymbols();
+	job->funcSymbs = abb->symbolTable.getFuncSymbols();
 
 	auto ret = abb->symbolTable.getDataSymbolsAndDisasmSeeds();
-	auto& dataSymbs = ret.first;
-	auto& seeds = ret.second;
+	job->dataSymbs = std::move(ret.first);
+	job->seeds = std::move(ret.second);
+	auto& seeds = job->seeds;
 
 	// merge in analytics seeds
 	{
@@ -364,17 +428,228 @@ std::string ABB::DebuggerBackend::disasmProg() {
 		}
 	}
 
-	return abb->mcu->disassembler_disassembleProg(
+	launchDisasmJob(job);
+	return job;
+}
+std::shared_ptr<ABB::DebuggerBackend::DisasmJob> ABB::DebuggerBackend::startLoadJob(std::shared_ptr<const utils::MappedFile> file) {
+	auto job = createDisasmJob();
+	job->file = std::move(file);
+
+	launchDisasmJob(job);
+	return job;
+}
+
+static BinTools::SectionData getELFSection(const EmuUtils::ELF::ELFFile& elf, const char* name) {
+	const size_t ind = elf.getIndOfSectionWithName(name);
+	if (ind >= elf.sectionHeaders.size())
+		return {};
+	const auto& section = elf.sectionHeaders[ind];
+	return { elf.data + section.offset, (size_t)section.size };
+}
+
+std::shared_ptr<ABB::DebuggerBackend::DisasmJob> ABB::DebuggerBackend::startELFJob() {
+	auto job = createDisasmJob();
+	job->ctrl.progressFrom = 0.5f;
+
+	// the elf is immutable and kept alive by the job, so the sections can be used directly; the symbols come from the table
+	job->elf = abb->elfFile;
+	const EmuUtils::ELF::ELFFile& elf = *job->elf;
+	BinTools::SrcMixELF& srcMixELF = job->srcMixELF;
+	srcMixELF.text = getELFSection(elf, ".text");
+	{
+		const size_t textInd = elf.getIndOfSectionWithName(".text");
+		if (textInd < elf.sectionHeaders.size())
+			srcMixELF.textAddr = (uint32_t)elf.sectionHeaders[textInd].addr;
+	}
+	srcMixELF.debugLine = getELFSection(elf, ".debug_line");
+	srcMixELF.debugLineStr = getELFSection(elf, ".debug_line_str");
+	srcMixELF.debugStr = getELFSection(elf, ".debug_str");
+
+	for (auto& symb : abb->symbolTable.getFuncSymbols())
+		srcMixELF.symbols.push_back({ symb.first, symb.second, false });
+	for (auto& symb : abb->symbolTable.getDataSymbolsAndDisasmSeeds().first)
+		srcMixELF.symbols.push_back({ std::get<1>(symb), std::get<0>(symb), true });
+
+	launchDisasmJob(job);
+	return job;
+}
+
+void ABB::DebuggerBackend::DisasmJob::run() {
+	if (file) {
+		success = result.loadMapped(cons.get(), file, file->size(), &ctrl);
+		done = true;
+		return;
+	}
+
+	if (elf) {
+		Console* c = cons.get();
+		BinTools::InstDecoder decoder;
+		decoder.disassemble = [c](uint16_t word, uint16_t word2) {
+			return c->disassembler_disassembleRaw(word, word2);
+		};
+		decoder.getInstLen = [c](uint16_t word) {
+			return c->disassembler_getInstLen(word);
+		};
+
+		std::string srcMix;
+		try {
+			srcMix = BinTools::generateSrcMix(srcMixELF, decoder);
+		}
+		catch (const std::runtime_error& e) {
+			logRecive(LogUtils::LogLevel_Error, (std::string("Couldn't generate srcMix from ELF: ") + e.what()).c_str(), __FILE__, __LINE__, LU_MODULE, this);
+			done = true;
+			return;
+		}
+		ctrl.progress = ctrl.progressFrom;
+
+		if (!ctrl.cancel)
+			success = result.loadSrc(cons.get(), srcMix.c_str(), srcMix.c_str() + srcMix.size(), &ctrl);
+
+		done = true;
+		return;
+	}
+
+	std::string disasmed = cons->disassembler_disassembleProg(
 		srcLines.size() ? &srcLines : nullptr,
 		&funcSymbs, &dataSymbs, &seeds
 	);
+	ctrl.progress = ctrl.progressFrom;
+
+	if (!ctrl.cancel)
+		success = result.loadSrc(cons.get(), disasmed.c_str(), disasmed.c_str() + disasmed.size(), &ctrl);
+
+	done = true;
 }
+
+void ABB::DebuggerBackend::DisasmJob::logRecive(uint8_t logLevel, const char* msg, const char* fileName, int lineNum, const char* module, void* userData) {
+	DisasmJob* job = (DisasmJob*)userData;
+	std::lock_guard<std::mutex> lock(job->logsMutex);
+	job->logs.push_back({ logLevel, msg, fileName ? fileName : "", lineNum, module ? module : "" });
+}
+
+void ABB::DebuggerBackend::forwardDisasmJobLogs(DisasmJob& job) {
+	std::vector<DisasmJob::LogEntry> logs;
+	{
+		std::lock_guard<std::mutex> lock(job.logsMutex);
+		logs.swap(job.logs);
+	}
+
+	auto logContext = abb->logBackend.getLogContext();
+	for (auto& entry : logs) {
+		logContext.first(entry.level, entry.msg.c_str(), entry.fileName.c_str(), entry.lineNum, entry.module.c_str(), logContext.second);
+	}
+}
+
+void ABB::DebuggerBackend::updateDisasmJobs() {
+	for (size_t i = 0; i < srcMixs.size();) {
+		SrcMix& srcMix = srcMixs[i];
+		if (!srcMix.job) {
+			i++;
+			continue;
+		}
+
+		const bool done = srcMix.job->done;
+		forwardDisasmJobLogs(*srcMix.job);
+		if (!done) {
+			i++;
+			continue;
+		}
+
+		if (srcMix.job->success) {
+			srcMix.viewer.loadDisasmFile(std::move(srcMix.job->result));
+			if (srcMix.pendingEditFrom <= srcMix.pendingEditTo) // the job disassembled a copy of the flash from before these edits
+				srcMix.viewer.file.redisassembleRange(abb->mcu.get(), srcMix.pendingEditFrom, srcMix.pendingEditTo);
+			double ms = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - srcMix.job->startTime).count()/1000.0;
+			LU_LOGF(LogUtils::LogLevel_DebugOutput, "%s took: %f ms", srcMix.job->file ? "loading" : "disassembly", ms);
+		}
+		else {
+			LU_LOGF(LogUtils::LogLevel_Output, "%s of \"%s\" %s", srcMix.job->file ? "loading" : "disassembly", srcMix.viewer.title.c_str(), srcMix.job->ctrl.cancel ? "was canceled" : "failed");
+		}
+		srcMix.job = nullptr;
+		srcMix.pendingEditFrom = -1;
+		srcMix.pendingEditTo = 0;
+
+		if (srcMix.viewer.file.isEmpty()) { // canceled before there was anything to show
+			srcMixs.erase(srcMixs.begin() + i);
+			if (selectedSrcMix >= srcMixs.size())
+				selectedSrcMix = srcMixs.size() - 1;
+		}
+		else {
+			i++;
+		}
+	}
+}
+
+void ABB::DebuggerBackend::onFlashEdited(Console::addrmcu_t from, Console::addrmcu_t to) {
+	flashEditFrom = std::min(flashEditFrom, from);
+	flashEditTo = std::max(flashEditTo, to);
+}
+
+void ABB::DebuggerBackend::applyFlashEdits() {
+	if (flashEditFrom > flashEditTo)
+		return;
+
+	const bool wholeFlash = flashEditFrom == 0 && flashEditTo + 1 >= abb->mcu->flash_size(); // e.g. a new rom got loaded
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (auto& srcMix : srcMixs) {
+		if (!srcMix.selfDisassembled)
+			continue;
+
+		if (srcMix.job) {
+			// the job disassembles a copy of the flash from before the edit
+			if (wholeFlash) {
+				srcMix.job->ctrl.cancel = true;
+				srcMix.job = startDisasmJob();
+				srcMix.pendingEditFrom = -1;
+				srcMix.pendingEditTo = 0;
+			}
+			else {
+				srcMix.pendingEditFrom = std::min(srcMix.pendingEditFrom, flashEditFrom);
+				srcMix.pendingEditTo = std::max(srcMix.pendingEditTo, flashEditTo);
+			}
+			continue;
+		}
+		if (srcMix.viewer.file.isEmpty())
+			continue;
+
+		srcMix.viewer.file.redisassembleRange(abb->mcu.get(), flashEditFrom, flashEditTo);
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	double ms = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()/1000.0;
+	LU_LOGF(LogUtils::LogLevel_DebugOutput, "updating disassembly of flash edit [%04x, %04x] took: %f ms", flashEditFrom, flashEditTo, ms);
+
+	flashEditFrom = -1;
+	flashEditTo = 0;
+}
+
 void ABB::DebuggerBackend::generateSrc() {
 	utils::AsmViewer& srcMix = addSrcMix(true);
 	
 	srcMix.title = ADD_ICON(ICON_FA_FILE_CODE) "Generated";
-	std::string disasmed = disasmProg();
-	srcMix.loadSrc(abb->mcu.get(), disasmed.c_str(), disasmed.c_str() + disasmed.size());
+	srcMixs.back().job = startDisasmJob();
+}
+
+void ABB::DebuggerBackend::generateSrcFromELF() {
+	if (!abb->elfFile)
+		return;
+
+	for (size_t i = 0; i < srcMixs.size(); i++) {
+		if (!srcMixs[i].fromELF)
+			continue;
+
+		if (srcMixs[i].job)
+			srcMixs[i].job->ctrl.cancel = true;
+		srcMixs[i].job = startELFJob();
+		selectedSrcMix = i;
+		return;
+	}
+
+	utils::AsmViewer& srcMix = addSrcMix(false);
+
+	srcMix.title = ADD_ICON(ICON_FA_FILE_CODE) "ELF";
+	srcMixs.back().fromELF = true;
+	srcMixs.back().job = startELFJob();
 }
 
 void ABB::DebuggerBackend::addSrc(const char* str, const char* title) {
@@ -384,16 +659,32 @@ void ABB::DebuggerBackend::addSrc(const char* str, const char* title) {
 	srcMix.loadSrc(abb->mcu.get(), str);
 }
 bool ABB::DebuggerBackend::addSrcFile(const char* path) {
-	std::string content;
+	std::shared_ptr<const utils::MappedFile> file;
 	try {
-		content = StringUtils::loadFileIntoString(path);
+		file = std::make_shared<const utils::MappedFile>(path);
 	}
 	catch (const std::runtime_error&) {
 		return false;
 	}
 
-	addSrc(content.c_str(), (std::string(ADD_ICON(ICON_FA_FILE_CODE)) + StringUtils::getFileName(path)).c_str());
+	utils::AsmViewer& srcMix = addSrcMix(false);
+	srcMix.title = std::string(ADD_ICON(ICON_FA_FILE_CODE)) + StringUtils::getFileName(path);
+
+	// big listings take a while to parse, so we show the start of the file right away and parse the whole thing in the background.
+	// The line index isnt shared with the viewer while it is being built (the worker would append to it while it gets drawn),
+	// instead the preview gets replaced by the whole file once the load job is done
+	constexpr size_t previewSize = 256 * 1024;
+	if (file->size() <= previewSize) {
+		srcMix.file.loadMapped(abb->mcu.get(), file);
+		return true;
+	}
+
+	size_t previewLen = previewSize;
+	while (previewLen > 0 && file->data()[previewLen - 1] != '\n')
+		previewLen--;
+	srcMix.file.loadMapped(abb->mcu.get(), file, previewLen);
 
+	srcMixs.back().job = startLoadJob(file);
 	return true;
 }
 
@@ -402,6 +693,9 @@ size_t ABB::DebuggerBackend::SrcMix::sizeBytes() const {
 
 	sum += viewer.sizeBytes();
 	sum += sizeof(selfDisassembled);
+	sum += sizeof(job);
+	sum += sizeof(pendingEditFrom);
+	sum += sizeof(pendingEditTo);
 
 	return sum;
 }
@@ -424,6 +718,8 @@ size_t ABB::DebuggerBackend::sizeBytes() const {
 	sum += sizeof(selectedSrcMix);
 	sum += sizeof(stepFrame);
 	sum += sizeof(haltOnReset);
+	sum += sizeof(flashEditFrom);
+	sum += sizeof(flashEditTo);
 
 	return sum;
 }
@@ -3,15 +3,22 @@
 
 #include <string>
 #include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <tuple>
+#include <chrono>
 #include <stdint.h>
 
 #include "../Console.h"
+#include "ElfReader.h"
 
 #include "ImGuiFD_internal.h"
 
 #include "../utils/asmViewer.h"
 
 #include "../utils/DisasmFile.h"
+#include "../bintools/bintools.h"
 
 namespace ABB{
     class ArduboyBackend;
@@ -38,13 +45,60 @@ namespace ABB{
 
         ImGuiFD::FDInstance loadSrcMix;
         bool drawLoadGenerateButtons(); // return true if a button was pressed
-        std::string disasmProg();
+
+        // disassembling a whole program can take a while, so it is done on a worker thread
+        struct DisasmJob {
+            std::unique_ptr<Console> cons; // own copy of the mcu, so the emulation can continue in the meantime
+
+            std::vector<std::pair<uint32_t, std::string>> srcLines;
+            std::vector<std::pair<uint32_t, std::string>> funcSymbs;
+            std::vector<std::tuple<std::string, uint32_t, uint32_t>> dataSymbs;
+            std::vector<uint32_t> seeds;
+
+            std::shared_ptr<const utils::MappedFile> file; // if set, this file gets loaded instead of disassembling the program
+            std::shared_ptr<const EmuUtils::ELF::ELFFile> elf; // if set, the srcMix gets generated from the debug info of this elf instead
+            BinTools::SrcMixELF srcMixELF; // points into elf
+
+            std::chrono::high_resolution_clock::time_point startTime;
+            DisasmFile::LoadControl ctrl;
+            std::atomic<bool> done{false};
+            bool success = false; // only valid if done
+            DisasmFile result;
+
+            struct LogEntry {
+                uint8_t level;
+                std::string msg;
+                std::string fileName;
+                int lineNum;
+                std::string module;
+            };
+            std::mutex logsMutex;
+            std::vector<LogEntry> logs; // logs generated by the worker, forwarded by the ui thread
+
+            void run();
+            static void logRecive(uint8_t logLevel, const char* msg, const char* fileName, int lineNum, const char* module, void* userData);
+        };
+        std::shared_ptr<DisasmJob> createDisasmJob();
+        void launchDisasmJob(const std::shared_ptr<DisasmJob>& job);
+        std::shared_ptr<DisasmJob> startDisasmJob();
+        std::shared_ptr<DisasmJob> startLoadJob(std::shared_ptr<const utils::MappedFile> file);
+        std::shared_ptr<DisasmJob> startELFJob();
+        void updateDisasmJobs();
+        void forwardDisasmJobLogs(DisasmJob& job);
+
+        Console::addrmcu_t flashEditFrom = -1; // range of flash bytes that got edited since the last frame (from > to if none)
+        Console::addrmcu_t flashEditTo = 0;
+        void applyFlashEdits();
     public:
         std::string winName;
         bool* open;
         struct SrcMix {
             utils::AsmViewer viewer;
             bool selfDisassembled;
+            bool fromELF = false; // generated from the loaded elf, gets reused when generating from an elf again
+            std::shared_ptr<DisasmJob> job; // set while (re-)disassembling in the background
+            Console::addrmcu_t pendingEditFrom = -1; // flash edited while the job was running, applied once its result is swapped in (from > to if none)
+            Console::addrmcu_t pendingEditTo = 0;
 
             size_t sizeBytes() const;
         };
@@ -63,6 +117,8 @@ namespace ABB{
         void addSrc(const char* str, const char* title = NULL);
         bool addSrcFile(const char* path);
         void generateSrc();
+        void generateSrcFromELF(); // like "objdump -d -l -S", needs abb->elfFile; replaces the previous one generated from an elf
+        void onFlashEdited(Console::addrmcu_t from, Console::addrmcu_t to); // self disassembled srcMixs get updated on the next draw
 
         size_t sizeBytes() const;
     };
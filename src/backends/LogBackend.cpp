@@ -1,5 +1,14 @@
 #include "LogBackend.h"
 
+#include <cstring>
+#include <cctype>
+#include <cinttypes>
+#include <algorithm>
+#include <regex>
+#if !defined(__EMSCRIPTEN__)
+#include <thread>
+#endif
+
 #include "raylib.h"
 
 #include "imgui_internal.h"
@@ -26,7 +35,7 @@ ABB::LogBackend::Settings ABB::LogBackend::settings;
 #if USE_ICONS
 std::map<std::string, std::pair<ImVec4,std::string>> ABB::LogBackend::moduleIconMap;
 #endif
-std::vector<ABB::LogBackend::Entry> ABB::LogBackend::systemLogs;
+ABB::utils::LogStore ABB::LogBackend::systemLogs(ABB::LogBackend::settings.maxEntries);
 
 void ABB::LogBackend::init() {
     SetTraceLogCallback([](int logLevel, const char* text, va_list args) {
@@ -87,7 +96,7 @@ void ABB::LogBackend::init() {
 }
 
 
-ABB::LogBackend::LogBackend(Console* mcu, const char* winName, bool* open) : mcu(mcu), winName(winName), open(open) {
+ABB::LogBackend::LogBackend(Console* mcu, const char* winName, bool* open) : logs(settings.maxEntries), mcu(mcu), winName(winName), open(open) {
     activateLog();
     mcu->setLogCallB([](uint8_t logLevel, const char* msg, const char* fileName, int lineNum, const char* module, void* userData) {
         ((LogBackend*)userData)->addLog(logLevel, msg, fileName, lineNum, module);
@@ -95,14 +104,67 @@ ABB::LogBackend::LogBackend(Console* mcu, const char* winName, bool* open) : mcu
 }
 
 void ABB::LogBackend::systemAddLog(uint8_t logLevel, const std::string& msg, const char* fileName, int lineNum, const char* module) {
-    systemLogs.push_back({ logLevel,msg,module ? module : "",fileName ? fileName : "",lineNum, idCntr++});
+    systemLogs.add(logLevel, msg.c_str(), msg.size(), module, fileName, lineNum, idCntr++);
 }
 
 void ABB::LogBackend::addLog(uint8_t logLevel, const char* msg, const char* fileName, int lineNum, const char* module) {
-    updateCacheWithSystemLog();
-    logs.push_back({logLevel,msg,module?module:"",fileName?fileName:"",lineNum, idCntr++});
-    if (logLevel >= filterLevel)
-        cache.push_back({ true, logs.size() - 1 });
+    queue.push(logLevel, msg, fileName, lineNum, module);
+}
+
+void ABB::LogBackend::update() {
+    const double time = ImGui::GetTime();
+    for (const utils::LogQueue::Msg* msg; (msg = queue.front()) != nullptr; queue.pop()) {
+        addEntry(msg->level, msg->msg.c_str(), msg->msg.size(), msg->fileName.c_str(), msg->lineNum, msg->module.c_str(), time);
+    }
+
+    const size_t dropped = queue.takeDropped();
+    if (dropped > 0) {
+        const std::string msg = StringUtils::format("%" CU_PRIuSIZE " log messages were dropped, because more than %" CU_PRIuSIZE " came in during one frame", dropped, queue.capacity());
+        insertEntry(LogLevel_Warning, msg.c_str(), msg.size(), __FILE__, __LINE__, LU_MODULE);
+    }
+
+    for (size_t i = 0; i < moduleRates.size(); i++) {
+        ModuleRate& rate = moduleRates[i];
+        if (rate.suppressed > 0 && time - rate.windowStart >= 1)
+            reportSuppressed((utils::LogStore::name_t)i, rate);
+    }
+}
+
+void ABB::LogBackend::addEntry(uint8_t logLevel, const char* msg, size_t msgLen, const char* fileName, int lineNum, const char* module, double time) {
+    if (settings.collapseRepeats && logs.repeatLast(logLevel, msg, msgLen, module, fileName, lineNum))
+        return;
+
+    if (settings.moduleRateLimit > 0) {
+        const utils::LogStore::name_t moduleName = logs.intern(module);
+        if (moduleName >= moduleRates.size())
+            moduleRates.resize(moduleName + 1);
+
+        ModuleRate& rate = moduleRates[moduleName];
+        if (time - rate.windowStart >= 1) {
+            if (rate.suppressed > 0)
+                reportSuppressed(moduleName, rate);
+            rate.windowStart = time;
+            rate.cnt = 0;
+        }
+
+        if (rate.cnt >= settings.moduleRateLimit) {
+            rate.suppressed++;
+            return;
+        }
+        rate.cnt++;
+    }
+
+    insertEntry(logLevel, msg, msgLen, fileName, lineNum, module);
+}
+
+void ABB::LogBackend::insertEntry(uint8_t logLevel, const char* msg, size_t msgLen, const char* fileName, int lineNum, const char* module) {
+    logs.add(logLevel, msg, msgLen, module, fileName, lineNum, idCntr++);
+}
+
+void ABB::LogBackend::reportSuppressed(utils::LogStore::name_t module, ModuleRate& rate) {
+    const std::string msg = StringUtils::format("%" CU_PRIuSIZE " messages from \"%s\" were suppressed (limit is %d per second)", rate.suppressed, logs.getName(module).c_str(), settings.moduleRateLimit);
+    insertEntry(LogLevel_Warning, msg.c_str(), msg.size(), __FILE__, __LINE__, LU_MODULE);
+    rate.suppressed = 0;
 }
 
 void ABB::LogBackend::logRecive(uint8_t logLevel, const char* msg, const char* fileName, int lineNum, const char* module, void* userData) {
@@ -117,84 +179,212 @@ void ABB::LogBackend::activateLog() const {
     LogUtils::activateLogTarget(logRecive, (void*)this);
 }
 
-ABB::LogBackend::Entry& ABB::LogBackend::getEntryFromCache(size_t i) {
-    auto& cacheEntry = cache[i];
-    return (cacheEntry.first ? logs : systemLogs)[cacheEntry.second];
+ImVec4 ABB::LogBackend::getLevelColor(uint8_t level) {
+    ImVec4 col = logColors[level];
+    if(col.w < 0) {
+        col = ImGui::GetStyleColorVec4(ImGuiCol_Text) * ImVec4{-col.w,-col.w,-col.w,1};
+    }
+    return col;
 }
 
-void ABB::LogBackend::updateCacheWithSystemLog() {
-    if (lastUpdatedSystemLogLen != systemLogs.size()) {
-        lastUpdatedSystemLogLen = systemLogs.size();
-        size_t lastId = 0;
-        if (cache.size() > 0)
-            lastId = getEntryFromCache(0).id;
+void ABB::LogBackend::SearchJob::run() {
+    std::regex regex;
+    if (useRegex) {
+        try {
+            regex = std::regex(query, caseSensitive ? std::regex::ECMAScript : (std::regex::ECMAScript | std::regex::icase));
+        }
+        catch (const std::regex_error& e) {
+            error = StringUtils::format("Invalid regex: %s", e.what());
+            done = true;
+            return;
+        }
+    }
 
-        size_t sysInd = 0;
-        while (sysInd < systemLogs.size() && systemLogs[sysInd].id < lastId)
-            sysInd++;
+    auto charEq = [](char a, char b) {
+        return std::tolower((unsigned char)a) == std::tolower((unsigned char)b);
+    };
+
+    std::vector<Match> found;
+    for (auto& ref : chunks) {
+        const char* data = ref.chunk->data.get();
+        size_t ind = ref.chunk->firstEntry;
+        for (size_t off = 0; off < ref.used; ind++) {
+            const char* msg = data + off;
+            const char* msgEnd = msg + std::strlen(msg);
+            off += msgEnd - msg + 1;
+
+            bool isMatch;
+            if (useRegex)
+                isMatch = std::regex_search(msg, msgEnd, regex);
+            else if (caseSensitive)
+                isMatch = std::search(msg, msgEnd, query.begin(), query.end()) != msgEnd;
+            else
+                isMatch = std::search(msg, msgEnd, query.begin(), query.end(), charEq) != msgEnd;
+
+            if (isMatch)
+                found.push_back(Match{ ref.isSystemLog, ind });
+        }
 
-        for (size_t i = sysInd; i < systemLogs.size(); i++) {
-            if (systemLogs[i].level >= filterLevel) {
-                cache.push_back({false, i});
-            }
+        if (found.size() > 0) {
+            std::lock_guard<std::mutex> lock(matchesMutex);
+            newMatches.insert(newMatches.end(), found.begin(), found.end());
         }
+        found.clear();
+        scannedBytes += ref.used;
+
+        if (cancel)
+            break;
     }
+    done = true;
 }
 
-void ABB::LogBackend::redoCache() {
-    cache.clear();
-    if (!settings.showSystemLog) {
-        for (size_t i = 0; i < logs.size(); i++) {
-            if (logs[i].level > filterLevel)
-                cache.push_back({ true, i });
+void ABB::LogBackend::startSearch() {
+    if (searchJob)
+        searchJob->cancel = true;
+    searchJob = nullptr;
+    searchMatches.clear();
+    searchError = "";
+    highlightId = -1;
+
+    if (searchStr.size() == 0)
+        return;
+
+    auto job = std::make_shared<SearchJob>();
+    job->query = searchStr;
+    job->useRegex = searchRegex;
+    job->caseSensitive = searchCaseSensitive;
+
+    // only the chunks get shared with the worker, it never touches the stores themselves
+    auto addChunks = [&](const utils::LogStore& store, bool isSystemLog) {
+        for (auto& chunk : store.getChunks()) {
+            job->chunks.push_back(SearchJob::ChunkRef{ chunk, chunk->used, isSystemLog });
+            job->totalBytes += chunk->used;
         }
+    };
+    addChunks(logs, false);
+    if (settings.showSystemLog)
+        addChunks(systemLogs, true);
+
+    searchJob = job;
+#if defined(__EMSCRIPTEN__)
+    job->run(); // no threads available
+#else
+    std::thread([job] {
+        job->run();
+    }).detach();
+#endif
+}
+
+void ABB::LogBackend::updateSearch() {
+    if (!searchJob)
+        return;
+
+    const bool done = searchJob->done;
+    {
+        std::lock_guard<std::mutex> lock(searchJob->matchesMutex);
+        searchMatches.insert(searchMatches.end(), searchJob->newMatches.begin(), searchJob->newMatches.end());
+        searchJob->newMatches.clear();
     }
-    else {
-        size_t logInd = 0;
-        size_t sysInd = 0;
-        while (logInd < logs.size() || sysInd < systemLogs.size()) {
-            size_t logID = -1;
-            while (logInd < logs.size()) {
-                logID = logs[logInd].id;
-
-                if (logs[logInd].level >= filterLevel)
-                    break;
-
-                logID = -1;
-                logInd++;
-            }
-            size_t systemLogID = -1;
-            while (sysInd < systemLogs.size()) {
-                systemLogID = systemLogs[sysInd].id;
 
-                if (systemLogs[sysInd].level >= filterLevel)
-                    break;
+    if (done) {
+        searchError = searchJob->error;
+        searchJob = nullptr;
+    }
+}
 
-                systemLogID = -1;
-                sysInd++;
-            }
+void ABB::LogBackend::jumpTo(const Match& match) {
+    const utils::LogStore& store = match.isSystemLog ? systemLogs : logs;
+    if (!store.has(match.ind))
+        return; // got removed in the meantime
 
-            if (logID == (size_t)-1 && systemLogID == (size_t)-1)
-                break;
+    const Entry& entry = store.get(match.ind);
+    // make sure the entry is visible
+    if (entry.level < filterLevel)
+        filterLevel = entry.level;
+    if (match.isSystemLog)
+        settings.showSystemLog = true;
 
-            if (logID < systemLogID) {
-                cache.push_back({true, logInd});
-                logInd++;
-            }
-            else {
-                cache.push_back({false, sysInd});
-                sysInd++;
+    jumpToId = entry.id;
+    highlightId = entry.id;
+}
+
+void ABB::LogBackend::drawSearch() {
+    updateSearch();
+
+    bool changed = false;
+    ImGui::PushItemWidth(250);
+    changed |= ImGuiExt::InputTextString("##search", "Search", &searchStr);
+    ImGui::PopItemWidth();
+    ImGui::SameLine();
+    changed |= ImGui::Checkbox("Regex", &searchRegex);
+    ImGui::SameLine();
+    changed |= ImGui::Checkbox("Case Sensitive", &searchCaseSensitive);
+    ImGui::SameLine();
+    if (ImGui::Button("Search") || changed)
+        startSearch(); // also searches the entries that got added since the last search
+
+    if (searchStr.size() == 0)
+        return;
+
+    if (searchError.size() > 0) {
+        ImGuiExt::TextColored({1,0.2f,0.2f,1}, searchError.c_str());
+        return;
+    }
+
+    if (searchJob) {
+        const float progress = searchJob->totalBytes > 0 ? (float)searchJob->scannedBytes / searchJob->totalBytes : 1;
+        ImGui::Text("Searching... %.0f%% (%" CU_PRIuSIZE " matches)", progress * 100, searchMatches.size());
+    }
+    else {
+        ImGui::Text("%" CU_PRIuSIZE " matches", searchMatches.size());
+    }
+
+    if (searchMatches.size() == 0)
+        return;
+
+    const float height = std::min(searchMatches.size(), (size_t)8) * ImGui::GetTextLineHeightWithSpacing() + ImGui::GetStyle().WindowPadding.y * 2;
+    if (ImGui::BeginChild("searchMatches", { 0, height }, true)) {
+        ImGuiListClipper clipper;
+        clipper.Begin((int)searchMatches.size());
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                const Match& match = searchMatches[i];
+                const utils::LogStore& store = match.isSystemLog ? systemLogs : logs;
+
+                ImGui::PushID(i);
+                if (!store.has(match.ind)) {
+                    ImGui::TextDisabled("(removed)");
+                }
+                else {
+                    const Entry& entry = store.get(match.ind);
+                    if (ImGui::Selectable("##match", entry.id == highlightId))
+                        jumpTo(match);
+                    ImGui::SameLine();
+                    ImGuiExt::TextColored(getLevelColor(entry.level), entry.msg, entry.msg + entry.msgLen);
+                }
+                ImGui::PopID();
             }
         }
+        clipper.End();
     }
+    ImGui::EndChild();
+}
+
+void ABB::LogBackend::updateView() {
+    view.clear();
+    view.addStore(&logs, filterLevel);
+    if (settings.showSystemLog)
+        view.addStore(&systemLogs, filterLevel);
 }
 
 void ABB::LogBackend::draw() {
-    updateCacheWithSystemLog();
+    if (logs.getMaxEntries() != (size_t)settings.maxEntries)
+        logs.setMaxEntries(settings.maxEntries);
+    if (systemLogs.getMaxEntries() != (size_t)settings.maxEntries)
+        systemLogs.setMaxEntries(settings.maxEntries);
 
     if(ImGui::Begin(winName.c_str(), open)){
         winFocused = ImGui::IsWindowFocused();
-        bool changed = false;
         ImGui::PushItemWidth(100);
         {
 #if USE_ICONS
@@ -205,22 +395,16 @@ void ABB::LogBackend::draw() {
             if (ImGui::BeginCombo("Filter Level", buf)) {
                 for (size_t i = 0; i < LogUtils::LogLevel_COUNT; i++) {
                     std::snprintf(buf, sizeof(buf), "%s %s", logLevelIcons[i], LogUtils::logLevelStrs[i]);
-                    if (ImGui::Selectable(buf)) {
-                        if (filterLevel != i)
-                            changed = true;
+                    if (ImGui::Selectable(buf))
                         filterLevel = (uint8_t)i;
-                    }
                 }
                 ImGui::EndCombo();
             }
 #else
             if (ImGui::BeginCombo("Filter Level", A32u4::ATmega32u4::logLevelStrs[filterLevel])) {
                 for (size_t i = 0; i < A32u4::ATmega32u4::LogLevel_COUNT; i++) {
-                    if (ImGui::Selectable(A32u4::ATmega32u4::logLevelStrs[i])) {
-                        if (filterLevel != i)
-                            changed = true;
+                    if (ImGui::Selectable(A32u4::ATmega32u4::logLevelStrs[i]))
                         filterLevel = (uint8_t)i;
-                    }
                 }
                 ImGui::EndCombo();
             }
@@ -229,12 +413,7 @@ void ABB::LogBackend::draw() {
         ImGui::PopItemWidth();
 
         ImGui::SameLine();
-        if (ImGui::Checkbox("System Log", &settings.showSystemLog))
-            changed = true;
-
-        if (changed) {
-            redoCache();
-        }
+        ImGui::Checkbox("System Log", &settings.showSystemLog);
 
         ImGui::SameLine();
         ImGui::Checkbox("Autoscroll", &settings.autoScroll);
@@ -244,6 +423,10 @@ void ABB::LogBackend::draw() {
             clear();
         }
 
+        drawSearch();
+
+        updateView();
+
         ImGui::PushStyleVar(ImGuiStyleVar_CellPadding, { 1, 1 });
         if(ImGui::BeginTable((winName+" logWin").c_str(), 4, ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_Hideable | ImGuiTableFlags_BordersOuter | ImGuiTableFlags_ScrollY)){ //ImGuiTableFlags_Resizable
             ImGui::TableSetupScrollFreeze(0, 1); // Make top row always visible
@@ -254,24 +437,34 @@ void ABB::LogBackend::draw() {
             ImGui::TableSetupColumn("File info", ImGuiTableColumnFlags_DefaultHide, 170);
             ImGui::TableHeadersRow();
 
+            const bool jumped = jumpToId != (size_t)-1;
+            if (jumped) {
+                const float rowHeight = ImGui::GetTextLineHeight() + ImGui::GetStyle().CellPadding.y * 2;
+                ImGui::SetScrollY(view.rankOf(jumpToId) * rowHeight - ImGui::GetWindowHeight() / 2);
+                jumpToId = -1;
+            }
+
             ImGuiListClipper clipper;
-            clipper.Begin((int)cache.size());
+            clipper.Begin((int)view.size());
             while (clipper.Step()) {
+                visibleItems.clear();
+                view.get(clipper.DisplayStart, clipper.DisplayEnd, &visibleItems);
                 for (int line_no = clipper.DisplayStart; line_no < clipper.DisplayEnd; line_no++) {
-                    auto& entry = getEntryFromCache(line_no);
+                    const utils::LogStore& store = *visibleItems[line_no - clipper.DisplayStart].store;
+                    const Entry& entry = store.get(visibleItems[line_no - clipper.DisplayStart].ind);
                     DU_ASSERT(entry.level < LogUtils::LogLevel_COUNT);
 
-                    ImVec4 col = logColors[entry.level];
-                    if(col.w < 0) {
-                        col = ImGui::GetStyleColorVec4(ImGuiCol_Text) * ImVec4{-col.w,-col.w,-col.w,1};
-                    }
+                    const ImVec4 col = getLevelColor(entry.level);
 
                     ImGui::TableNextRow();
+                    if (entry.id == highlightId)
+                        ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg1, IM_COL32(50, 50, 255, 100));
                     ImGui::TableNextColumn();
 
-                    if (entry.module.size() > 0) {
+                    if (entry.module != 0) {
+                        const std::string& module = store.getName(entry.module);
 #if USE_ICONS
-                        auto res = moduleIconMap.find(entry.module);
+                        auto res = moduleIconMap.find(module);
 
                         const char* icon = ICON_FA_QUESTION;
                         ImVec4 iconCol = { 1,1,1,1 };
@@ -283,12 +476,12 @@ void ABB::LogBackend::draw() {
                         ImGuiExt::TextColored(iconCol, icon);
                         if (ImGui::IsItemHovered()) {
                             ImGui::BeginTooltip();
-                            ImGui::TextColored(iconCol, "[%s] ", entry.module.c_str());
+                            ImGui::TextColored(iconCol, "[%s] ", module.c_str());
                             ImGui::EndTooltip();
                         }
 
 #else
-                        ImGui::TextColored(col, "[%s] ", entry.module.c_str());
+                        ImGui::TextColored(col, "[%s] ", module.c_str());
 #endif
                     }
 
@@ -307,24 +500,28 @@ void ABB::LogBackend::draw() {
 
                     ImGui::TableNextColumn();
                     
-                    ImGuiExt::TextColored(col, entry.msg.c_str());
+                    ImGuiExt::TextColored(col, entry.msg, entry.msg + entry.msgLen);
                     if(ImGui::IsItemHovered()) {
                         ImGui::SetNextWindowSize({300,0});
                         ImGui::BeginTooltip();
-                        ImGui::TextWrapped("%s", entry.msg.c_str());
+                        ImGui::TextWrapped("%s", entry.msg);
                         ImGui::EndTooltip();
                     }
+                    if (entry.count > 1) {
+                        ImGui::SameLine();
+                        ImGui::TextDisabled(" (x%" PRIu32 ")", entry.count);
+                    }
 
                     ImGui::TableNextColumn();
-                    if((entry.fileName.size() > 0 || entry.lineNum != -1))
+                    if((entry.fileName != 0 || entry.lineNum != -1))
                         ImGui::TextColored(col, "[%s:%d]", 
-                            entry.fileName.size() > 0 ? StringUtils::getFileName(entry.fileName.c_str()) : "N/A", 
+                            entry.fileName != 0 ? StringUtils::getFileName(store.getName(entry.fileName).c_str()) : "N/A", 
                             entry.lineNum
                         );
                 }
             }
             clipper.End();
-            if (settings.autoScroll && ImGui::GetScrollY() >= ImGui::GetScrollMaxY())
+            if (settings.autoScroll && !jumped && ImGui::GetScrollY() >= ImGui::GetScrollMaxY())
                 ImGui::SetScrollHereY(1.0f);
             ImGui::EndTable();
         }
@@ -341,7 +538,6 @@ void ABB::LogBackend::draw() {
 
 void ABB::LogBackend::clear() {
     logs.clear();
-    cache.clear();
 }
 
 const char* ABB::LogBackend::getWinName() const {
@@ -355,6 +551,19 @@ bool ABB::LogBackend::isWinFocused() const {
 }
 
 void ABB::LogBackend::drawSettings() {
+    ImGui::PushItemWidth(120);
+    if (ImGui::InputInt("Max Entries", &settings.maxEntries, 1000, 10000))
+        settings.maxEntries = std::max(settings.maxEntries, 0);
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Maximum number of entries kept per log, older ones get removed (0 = unlimited)");
+    if (ImGui::InputInt("Module Rate Limit", &settings.moduleRateLimit, 100, 1000))
+        settings.moduleRateLimit = std::max(settings.moduleRateLimit, 0);
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("Maximum number of new entries per module per second, the rest gets suppressed (0 = unlimited)");
+    ImGui::PopItemWidth();
+    ImGui::Checkbox("Collapse Repeated Messages", &settings.collapseRepeats);
+    ImGui::Separator();
+
     for(size_t i = 0; i<LogLevel_COUNT; i++) {
         if(i>0)
             ImGui::Separator();
@@ -392,30 +601,25 @@ void ABB::LogBackend::drawSettings() {
     }
 }
 
-size_t ABB::LogBackend::Entry::sizeBytes() const {
+size_t ABB::LogBackend::sizeBytes() const {
     size_t sum = 0; 
 
-    sum += sizeof(level);
-    sum += DataUtils::approxSizeOf(msg);
-
-    sum += DataUtils::approxSizeOf(module);
-    sum += DataUtils::approxSizeOf(fileName);
-    sum += sizeof(lineNum);
-
-    sum += sizeof(id);
-
-    return sum;
-}
+    sum += logs.sizeBytes();
 
-size_t ABB::LogBackend::sizeBytes() const {
-    size_t sum = 0; 
+    sum += sizeof(view);
+    sum += visibleItems.capacity() * sizeof(utils::LogStore::View::Item);
 
-    for (auto& e : logs)
-        sum += e.sizeBytes();
-    sum += sizeof(logs) + (logs.capacity()-logs.size())*sizeof(Entry);
+    sum += sizeof(searchJob);
+    sum += DataUtils::approxSizeOf(searchStr);
+    sum += sizeof(searchRegex);
+    sum += sizeof(searchCaseSensitive);
+    sum += DataUtils::approxSizeOf(searchError);
+    sum += searchMatches.capacity() * sizeof(Match);
+    sum += sizeof(jumpToId);
+    sum += sizeof(highlightId);
 
-    sum += sizeof(lastUpdatedSystemLogLen);
-    sum += DataUtils::approxSizeOf(cache);
+    sum += queue.sizeBytes();
+    sum += moduleRates.capacity() * sizeof(ModuleRate);
 
     sum += sizeof(mcu);
 
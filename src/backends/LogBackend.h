@@ -4,6 +4,9 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <memory>
+#include <atomic>
+#include <mutex>
 
 #define IMGUI_DEFINE_MATH_OPERATORS 1
 #include "imgui.h"
@@ -11,6 +14,8 @@
 #include "imgui/icons.h"
 
 #include "../Console.h"
+#include "../utils/logStore.h"
+#include "../utils/logQueue.h"
 
 #define SYS_LOG(_level_,_msg_) ABB::LogBackend::_SystemLog(_level_, SYS_LOG_MODULE, __FILE__, __LINE__, _msg_)
 #define SYS_LOGF(_level_,_msg_,...) ABB::LogBackend::_SystemLogf(_level_, SYS_LOG_MODULE, __FILE__, __LINE__, _msg_, __VA_ARGS__)
@@ -38,30 +43,77 @@ namespace ABB {
         static struct Settings {
             bool autoScroll = true;
             bool showSystemLog = true;
+            int maxEntries = 100000; // per log, 0 = unlimited
+            bool collapseRepeats = true;
+            int moduleRateLimit = 1000; // max new entries per module per second, 0 = unlimited
         } settings;
 
-        struct Entry {
-            uint8_t level;
-            std::string msg;
+        typedef utils::LogStore::Entry Entry;
 
-            std::string module;
-            std::string fileName;
-            int lineNum;
+        static size_t idCntr;
+        utils::LogStore logs;
+        static utils::LogStore systemLogs;
+        utils::LogStore::View view; // entries that pass the current filter
+        std::vector<utils::LogStore::View::Item> visibleItems;
+
+        void updateView();
+        static ImVec4 getLevelColor(uint8_t level);
 
-            size_t id;
+        // messages from the core (and everything else) go through the queue and get added in update()
+        utils::LogQueue queue;
 
-            size_t sizeBytes() const;
+        struct ModuleRate {
+            double windowStart = 0;
+            int cnt = 0;
+            size_t suppressed = 0;
         };
+        std::vector<ModuleRate> moduleRates; // [interned module name]
 
-        static size_t idCntr;
-        std::vector<Entry> logs;
-        static std::vector<Entry> systemLogs;
-        size_t lastUpdatedSystemLogLen = 0;
-        std::vector<std::pair<bool,size_t>> cache;
+        void addEntry(uint8_t logLevel, const char* msg, size_t msgLen, const char* fileName, int lineNum, const char* module, double time);
+        void insertEntry(uint8_t logLevel, const char* msg, size_t msgLen, const char* fileName, int lineNum, const char* module);
+        void reportSuppressed(utils::LogStore::name_t module, ModuleRate& rate);
 
-        Entry& getEntryFromCache(size_t i);
-        void redoCache();
-        void updateCacheWithSystemLog();
+        struct Match {
+            bool isSystemLog;
+            size_t ind;
+        };
+        // searching through the whole history can take a while, so it is done on a worker thread
+        struct SearchJob {
+            struct ChunkRef {
+                std::shared_ptr<const utils::LogStore::Chunk> chunk; // keeps the messages alive, even if they get evicted in the meantime
+                size_t used; // only what was written when the search started gets searched
+                bool isSystemLog;
+            };
+            std::vector<ChunkRef> chunks;
+            size_t totalBytes = 0;
+
+            std::string query;
+            bool useRegex = false;
+            bool caseSensitive = false;
+
+            std::atomic<bool> cancel{false};
+            std::atomic<bool> done{false};
+            std::atomic<size_t> scannedBytes{0};
+            std::string error; // only valid if done
+
+            std::mutex matchesMutex;
+            std::vector<Match> newMatches; // found by the worker, taken by the ui thread
+
+            void run();
+        };
+        std::shared_ptr<SearchJob> searchJob;
+        std::string searchStr;
+        bool searchRegex = false;
+        bool searchCaseSensitive = false;
+        std::string searchError;
+        std::vector<Match> searchMatches;
+        size_t jumpToId = -1; // entry to scroll to in the next table draw
+        size_t highlightId = -1;
+
+        void startSearch();
+        void updateSearch();
+        void drawSearch();
+        void jumpTo(const Match& match);
 
         Console* mcu;
     public:
@@ -72,6 +124,7 @@ namespace ABB {
 
         LogBackend(Console* mcu, const char* winName, bool* open);
 
+        void update(); // adds the queued messages, has to be called every frame
         void draw();
         void clear();
 
@@ -52,49 +52,74 @@ float ABB::SymbolBackend::distSqCols(const ImVec4& a, const ImVec4& b){
 	return MathUtils::sq(a.x-b.x) + MathUtils::sq(a.y-b.y) + MathUtils::sq(a.z-b.z) + MathUtils::sq(a.w-b.w);
 }
 
-bool ABB::SymbolBackend::compareSymbols(uint32_t a, uint32_t b) {
-	const EmuUtils::SymbolTable::Symbol* symbolA = abb->symbolTable.getSymbolById(a);
-	const EmuUtils::SymbolTable::Symbol* symbolB = abb->symbolTable.getSymbolById(b);
-
-	for (int i = 0; i < sortSpecs->SpecsCount; i++) {
-		auto& specs = sortSpecs->Specs[i];
-		int delta = 0;
-		switch (specs.ColumnUserID) {
-			case SB_NAME:
-				delta = std::strcmp(symbolA->name.c_str(), symbolB->name.c_str());
-				break;
-
-			case SB_VALUE:
-				delta = (int)symbolA->value - (int)symbolB->value;
-				break;
-
-			case SB_SIZE:
-				delta = (int)symbolA->size - (int)symbolB->size;
-				break;
-
-			case SB_FLAGS:
-				delta = std::strcmp(symbolA->flagStr.c_str(), symbolB->flagStr.c_str());
-				break;
-
-			case SB_SECTION:
-				delta = std::strcmp(symbolA->section.c_str(), symbolB->section.c_str());
-				break;
-
-			case SB_NOTES:
-				delta = std::strcmp(symbolA->name.c_str(), symbolB->name.c_str());
-				break;
-
-			case SB_ID:
-				delta = (int64_t)symbolA->id - (int64_t)symbolB->id;
-			
-		}
+bool ABB::SymbolBackend::updateSortKeys() {
+	const EmuUtils::SymbolTable& table = abb->symbolTable;
+	const EmuUtils::SymbolTable::SymbolList& list = table.getSymbols();
+	if (sortKeys.generation == abb->symbolIndex.getGeneration() && sortKeys.listData == (const void*)list.data() && sortKeys.listSize == list.size())
+		return false;
 
-		if (delta > 0)
-			return (specs.SortDirection == ImGuiSortDirection_Ascending) ? false : true;
-		if (delta < 0)
-			return (specs.SortDirection == ImGuiSortDirection_Ascending) ? true : false;
+	sortKeys.generation = abb->symbolIndex.getGeneration();
+	sortKeys.listData = list.data();
+	sortKeys.listSize = list.size();
+
+	const size_t num = list.size();
+	std::vector<const EmuUtils::SymbolTable::Symbol*> symbols(num);
+	sortKeys.ids.resize(num);
+	sortKeys.keys.assign(num * SB_COUNT, 0);
+	for (size_t i = 0; i < num; i++) {
+		symbols[i] = table.getSymbol(list, i);
+		sortKeys.ids[i] = symbols[i]->id;
+
+		uint64_t* keys = &sortKeys.keys[i * SB_COUNT];
+		keys[SB_VALUE] = symbols[i]->value;
+		keys[SB_SIZE] = symbols[i]->size;
+		keys[SB_ID] = symbols[i]->id;
 	}
-	return false;
+
+	std::vector<uint32_t> order(num);
+	auto rankStrings = [&](size_t column, std::string EmuUtils::SymbolTable::Symbol::* str) {
+		for (size_t i = 0; i < num; i++)
+			order[i] = (uint32_t)i;
+		std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+			return symbols[a]->*str < symbols[b]->*str;
+		});
+
+		uint64_t rank = 0;
+		for (size_t i = 0; i < num; i++) {
+			if (i > 0 && symbols[order[i]]->*str != symbols[order[i - 1]]->*str)
+				rank++;
+			sortKeys.keys[order[i] * SB_COUNT + column] = rank;
+		}
+	};
+	rankStrings(SB_NAME, &EmuUtils::SymbolTable::Symbol::name);
+	rankStrings(SB_FLAGS, &EmuUtils::SymbolTable::Symbol::flagStr);
+	rankStrings(SB_SECTION, &EmuUtils::SymbolTable::Symbol::section);
+	rankStrings(SB_NOTES, &EmuUtils::SymbolTable::Symbol::note);
+
+	return true;
+}
+
+void ABB::SymbolBackend::sortSymbols(const ImGuiTableSortSpecs* specs) {
+	const size_t num = sortKeys.ids.size();
+	std::vector<uint32_t> order(num);
+	for (size_t i = 0; i < num; i++)
+		order[i] = (uint32_t)i;
+
+	const uint64_t* keys = sortKeys.keys.data();
+	std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+		for (int i = 0; i < specs->SpecsCount; i++) {
+			const ImGuiTableColumnSortSpecs& spec = specs->Specs[i];
+			const uint64_t keyA = keys[a * SB_COUNT + spec.ColumnUserID];
+			const uint64_t keyB = keys[b * SB_COUNT + spec.ColumnUserID];
+			if (keyA != keyB)
+				return (spec.SortDirection == ImGuiSortDirection_Ascending) ? keyA < keyB : keyA > keyB;
+		}
+		return a < b;
+	});
+
+	symbolsSortedOrder.resize(num);
+	for (size_t i = 0; i < num; i++)
+		symbolsSortedOrder[i] = sortKeys.ids[order[i]];
 }
 
 void ABB::SymbolBackend::clearAddSymbol(){
@@ -161,6 +186,7 @@ void ABB::SymbolBackend::draw() {
 
 				if(ImGui::Button("OK")){
 					abb->symbolTable.addSymbol(std::move(addSymbol));
+					abb->symbolIndex.invalidate();
 					ImGui::CloseCurrentPopup();
 				}
 				ImGui::SameLine();
@@ -190,41 +216,19 @@ void ABB::SymbolBackend::draw() {
 					ImGui::TableHeadersRow();
 				}
 
-				if (symbolsSortedOrder.size() != abb->symbolTable.getSymbols().size()) {
-					std::set<uint32_t> seen;
-					for (size_t i = 0; i < symbolsSortedOrder.size();) {
-						if (abb->symbolTable.getSymbolById(symbolsSortedOrder[i]) == nullptr) {
-							symbolsSortedOrder.erase(symbolsSortedOrder.begin() + i);
-							continue;
-						}
-
-						seen.insert(symbolsSortedOrder[i]);
-						i++;
-					}
-
-					for (size_t i = 0; i < abb->symbolTable.getSymbols().size(); i++) {
-						const auto* symbol = abb->symbolTable.getSymbol(abb->symbolTable.getSymbols(),i);
-						if (seen.find(symbol->id) == seen.end()) {
-							symbolsSortedOrder.push_back(symbol->id);
-						}
-					}
+				if (updateSortKeys())
 					shouldResort = true;
-				}
 
 				if (ImGuiTableSortSpecs* specs = ImGui::TableGetSortSpecs()) {
 					if (specs->SpecsDirty || shouldResort) {
-						sortSpecs = specs;
-						std::sort(symbolsSortedOrder.begin(), symbolsSortedOrder.end(), [&](uint32_t a, uint32_t b) {
-							return compareSymbols(a, b);
-						});
-						sortSpecs = nullptr;
+						sortSymbols(specs);
 						specs->SpecsDirty = false;
 						shouldResort = false;
 					}
 				}
 
 				ImGuiListClipper clipper;
-				clipper.Begin((int)abb->symbolTable.getSymbols().size());
+				clipper.Begin((int)symbolsSortedOrder.size());
 				while (clipper.Step()) {
 					for(int i = clipper.DisplayStart; i<clipper.DisplayEnd; i++) {
 						const auto* symbol = abb->symbolTable.getSymbolById(symbolsSortedOrder[i]);
@@ -319,6 +323,7 @@ void ABB::SymbolBackend::draw() {
 bool ABB::SymbolBackend::loadSymbolDumpFile(const char* path){
 	try {
 		bool ret = abb->symbolTable.loadFromDumpFile(path);
+		abb->symbolIndex.invalidate();
 		if (ret)
 			LU_LOGF(LogUtils::LogLevel_Output, "sucessfully loaded file %s", path);
 		return ret;
@@ -437,7 +442,7 @@ const EmuUtils::SymbolTable::Symbol* ABB::SymbolBackend::drawAddrWithSymbol(EmuU
 	ImGui::BeginGroup();
 	ImGui::Text("%08" PRIx64, Addr);
 
-	const auto* symbol = abb->symbolTable.getSymbolByValue(Addr, list);
+	const auto* symbol = abb->symbolIndex.getSymbolByValue(Addr, list);
 	if (symbol) {
 		ImGui::SameLine();
 		ImGuiExt::TextColored(getSymbolColor(symbol->id), symbol->demangled.c_str());
@@ -559,7 +564,9 @@ size_t ABB::SymbolBackend::sizeBytes() const {
 
 	sum += DataUtils::approxSizeOf(symbolsSortedOrder);
 	sum += sizeof(shouldResort);
-	sum += sizeof(sortSpecs);
+	sum += sizeof(sortKeys);
+	sum += DataUtils::approxSizeOf(sortKeys.ids);
+	sum += DataUtils::approxSizeOf(sortKeys.keys);
 	sum += addSymbol.sizeBytes();
 
 	return sum;
@@ -26,11 +26,23 @@ namespace ABB {
             SB_FLAGS,
             SB_SECTION,
             SB_NOTES,
-            SB_ID
+            SB_ID,
+            SB_COUNT
         };
-        std::vector<uint32_t> symbolsSortedOrder;
+        std::vector<uint32_t> symbolsSortedOrder; // symbol ids
         bool shouldResort = true;
-        ImGuiTableSortSpecs* sortSpecs = nullptr;
+
+        // sort keys of all symbols, strings are replaced by their rank so sorting only compares integers
+        struct SortKeys {
+            size_t generation = -1; // of abb->symbolIndex when this was built
+            const void* listData = nullptr; // to notice changes that didnt call invalidate()
+            size_t listSize = 0;
+
+            std::vector<uint32_t> ids; // [i] = id of the ith symbol of the table
+            std::vector<uint64_t> keys; // [i*SB_COUNT + column]
+        } sortKeys;
+        bool updateSortKeys(); // returns true if they had to be rebuilt
+        void sortSymbols(const ImGuiTableSortSpecs* specs);
 
         EmuUtils::SymbolTable::Symbol addSymbol;
         void clearAddSymbol();
@@ -40,8 +52,6 @@ namespace ABB {
         static float distSqCols(const ImVec4& a, const ImVec4& b);
 
         static std::vector<std::string> demangeSymbols(std::vector<const char*> names, void* userData);
-
-        bool compareSymbols(uint32_t a, uint32_t b);
     public:
         SymbolBackend(ArduboyBackend* abb, const char* winName, bool* open);
 
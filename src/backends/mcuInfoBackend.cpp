@@ -142,23 +142,30 @@ void ABB::McuInfoBackend::draw() {
 					}
 
 					const EmuUtils::SymbolTable::SymbolList* list = nullptr;
+					const utils::SymbolIndex::Intervals* intervals = nullptr;
 					switch (hex.type) {
-						case Console::Hex::Type_Ram: list = &abb->symbolTable.getSymbolsRam(); break;
-						case Console::Hex::Type_Rom: list = &abb->symbolTable.getSymbolsRom(); break;
+						case Console::Hex::Type_Ram: list = &abb->symbolTable.getSymbolsRam(); intervals = &abb->symbolIndex.getRam(); break;
+						case Console::Hex::Type_Rom: list = &abb->symbolTable.getSymbolsRom(); intervals = &abb->symbolIndex.getRom(); break;
 					}
 
+					struct EditContext {
+						Console::Hex* hex;
+						McuInfoBackend* mib;
+					} editContext = { &hex, this };
 					if(hex.setData) {
 						hexViewers[i].setEditCallback([](size_t addr, uint8_t val, void* userData) {
-							((Console::Hex*)userData)->setData((addrmcu_t)addr, val);
-						}, &hex);
+							EditContext* ctx = (EditContext*)userData;
+							ctx->hex->setData((addrmcu_t)addr, val);
+							if (ctx->hex->type == Console::Hex::Type_Rom)
+								ctx->mib->abb->debuggerBackend.onFlashEdited((addrmcu_t)addr, (addrmcu_t)addr);
+						}, &editContext);
 					}else{
 						hexViewers[i].setEditCallback(nullptr, nullptr);
 					}
 					
 
-					hexViewers[i].draw(hex.data, hex.dataLen, &abb->symbolTable, list, hex.readCnt, hex.writeCnt);
-					if (hex.resetRWAnalytics)
-						hex.resetRWAnalytics();
+					// read/write counters get reset by the AnalyticsBackend once per frame
+					hexViewers[i].draw(hex.data, hex.dataLen, &abb->symbolTable, list, intervals, hex.readCnt, hex.writeCnt);
 
 					ImGui::TreePop();
 				}
@@ -249,13 +256,14 @@ void ABB::McuInfoBackend::draw() {
 								if (func("File", srcMixP.viewer.file.sizeBytes(), true)) {
 									const auto& file = srcMixP.viewer.file;
 									func("Contents", 
-										DataUtils::approxSizeOf(file.content) + DataUtils::approxSizeOf(file.addrs) + 
-										DataUtils::approxSizeOf(file.lines) + DataUtils::approxSizeOf(file.isLineProgram) + DataUtils::approxSizeOf(file.labels)
+										file.contentSizeBytes() + DataUtils::approxSizeOf(file.addrs) + 
+										DataUtils::approxSizeOf(file.lines) + DataUtils::approxSizeOf(file.isLineProgram) + DataUtils::approxSizeOf(file.labels) +
+										DataUtils::approxSizeOf(file.addrToLine) + DataUtils::approxSizeOf(file.prevActualAddrs) + DataUtils::approxSizeOf(file.nextActualAddrs)
 									);
 
 									if (func("Branch Data",
 										DataUtils::approxSizeOf(file.branchRoots) + DataUtils::approxSizeOf(file.branchRootInds) +
-										DataUtils::approxSizeOf(file.passingBranchesInds) + DataUtils::approxSizeOf(file.passingBranchesVec),
+										DataUtils::approxSizeOf(file.passingBranchesInds) + DataUtils::approxSizeOf(file.passingBranchesVec) + DataUtils::approxSizeOf(file.passingBranchesArena),
 										true
 									)) {
 										func("Branch",
@@ -263,7 +271,7 @@ void ABB::McuInfoBackend::draw() {
 										);
 
 										func("Passing Branches",
-											DataUtils::approxSizeOf(file.passingBranchesInds) + DataUtils::approxSizeOf(file.passingBranchesVec)
+											DataUtils::approxSizeOf(file.passingBranchesInds) + DataUtils::approxSizeOf(file.passingBranchesVec) + DataUtils::approxSizeOf(file.passingBranchesArena)
 										);
 
 										ImGui::TreePop();
@@ -367,6 +375,7 @@ void ABB::McuInfoBackend::drawStates() {
 					if(ImGui::Button("Load")){
 						abb->mcu->assign(entry.second.mcu.get());
 						abb->symbolTable = entry.second.symbolTable;
+						abb->symbolIndex.invalidate();
 						LU_LOGF(LogUtils::LogLevel_DebugOutput, "Loaded State \"%s\"", entry.first.c_str());
 					}
 					ImGui::SameLine();
@@ -421,7 +430,10 @@ bool ABB::McuInfoBackend::loadHexData(const char* path, size_t ind) {
 		LU_LOGF_(LogUtils::LogLevel_Error, "Could not open file: \"%s\"", e.what());
 		return false;
 	}
-	abb->mcu->getHexViewer(ind).setDataAll(&data[0], data.size());
+	const Console::Hex hex = abb->mcu->getHexViewer(ind);
+	hex.setDataAll(&data[0], data.size());
+	if (hex.type == Console::Hex::Type_Rom && hex.dataLen > 0)
+		abb->debuggerBackend.onFlashEdited(0, (addrmcu_t)(hex.dataLen - 1));
 
 	LU_LOGF(LogUtils::LogLevel_Output, "Successfully loaded file for Hex: %s", path);
 	return true;
@@ -4,6 +4,31 @@
 
 #if defined(_MSC_VER) && true
 #define EXTERNAL_
+#else
+#define CXXABI_DEMANGLE_ // gcc/clang (and so also mingw and emscripten) have the itanium demangler built in
+#endif
+
+#ifdef CXXABI_DEMANGLE_
+#include <cxxabi.h>
+#include <cstdlib>
+#endif
+
+#include "dwarfLines.h"
+
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <cstring>
+#include <cstdio>
+#include <stdexcept>
+#include <sys/types.h>
+#include <sys/stat.h>
+#if !defined(__EMSCRIPTEN__)
+#include <thread>
 #endif
 
 #ifdef _MSC_VER
@@ -134,7 +159,7 @@ class IOChildProcess {
 #endif
 
 bool BinTools::canDemangle() {
-#ifdef EXTERNAL_
+#if defined(EXTERNAL_) || defined(CXXABI_DEMANGLE_)
 	return true;
 #else
 	return false;
@@ -187,10 +212,83 @@ const char* get_cwd_(){
 #endif
 }
 
+#ifdef CXXABI_DEMANGLE_
+// behaves like c++filt: names that cant be demangled are returned as they are (but stripped)
+static std::string demangle(const char* str) {
+	auto strStripped = StringUtils::stripString(str);
+	std::string name(strStripped.first, strStripped.second);
+	// only mangled names, otherwise plain C symbols like "i" or "d" would get demangled as type encodings ("int", "double")
+	const char* mangled = name.c_str();
+	if (mangled[0] == '_' && mangled[1] == '_' && mangled[2] == 'Z')
+		mangled++; // some targets prefix symbols with an extra underscore
+	if (mangled[0] != '_' || mangled[1] != 'Z')
+		return name;
+
+	int status = 0;
+	char* res = abi::__cxa_demangle(mangled, nullptr, nullptr, &status);
+	if (status != 0 || res == nullptr)
+		return name;
+
+	std::string out = res;
+	std::free(res);
+	return out;
+}
+
+static std::mutex demangleCacheMutex;
+static std::unordered_map<std::string, std::string> demangleCache; // [mangled name] = demangled name
+#endif
+
 std::vector<std::string> BinTools::demangleList(const char** strs, size_t num) {
 	std::vector<std::string> out;
 
-#ifdef EXTERNAL_
+#if defined(CXXABI_DEMANGLE_)
+	out.resize(num);
+
+	// look everything up in the cache first, so only new names need to be demangled
+	std::vector<size_t> todo;
+	{
+		std::lock_guard<std::mutex> lock(demangleCacheMutex);
+		for (size_t i = 0; i < num; i++) {
+			auto res = demangleCache.find(strs[i]);
+			if (res != demangleCache.end())
+				out[i] = res->second;
+			else
+				todo.push_back(i);
+		}
+	}
+
+	auto work = [&](size_t from, size_t to) {
+		for (size_t i = from; i < to; i++) {
+			out[todo[i]] = demangle(strs[todo[i]]);
+		}
+	};
+
+#if !defined(__EMSCRIPTEN__)
+	constexpr size_t minPerThread = 512; // demangling is pretty fast, so threads only make sense for big lists
+	const size_t numThreads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), (todo.size() + minPerThread - 1) / minPerThread);
+	if (numThreads > 1) {
+		std::vector<std::thread> threads;
+		const size_t perThread = (todo.size() + numThreads - 1) / numThreads;
+		for (size_t t = 0; t < numThreads; t++) {
+			const size_t from = std::min(t * perThread, todo.size());
+			const size_t to = std::min(from + perThread, todo.size());
+			threads.emplace_back(work, from, to);
+		}
+		for (auto& thread : threads)
+			thread.join();
+	}
+	else
+#endif
+	{
+		work(0, todo.size());
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(demangleCacheMutex);
+		for (size_t i : todo)
+			demangleCache[strs[i]] = out[i];
+	}
+#elif defined(EXTERNAL_)
 	std::string list = "";
 	std::string placeHolder = "0______";
 	for (size_t i = 0; i < num; i++) {
@@ -244,6 +342,237 @@ std::vector<std::string> BinTools::demangleList(const char** strs, size_t num) {
 }
 
 
-std::string BinTools::generateSrcMix(const uint8_t* elfData, size_t elfDataLen) {
-	return "";
+namespace BinTools {
+	namespace SrcMix {
+		struct SourceFile {
+			std::string content;
+			std::vector<size_t> lineStarts;
+			int64_t mtime = 0;
+			uint64_t size = 0;
+
+			std::pair<const char*, const char*> getLine(uint32_t line) const { // line starts at 1
+				if (line == 0 || line > lineStarts.size())
+					return { nullptr, nullptr };
+				const char* start = content.c_str() + lineStarts[line - 1];
+				const char* end = content.c_str() + (line < lineStarts.size() ? lineStarts[line] - 1 : content.size());
+				while (end > start && (*(end - 1) == '\n' || *(end - 1) == '\r'))
+					end--;
+				return { start, end };
+			}
+		};
+
+		struct Chunk {
+			uint32_t start;
+			uint32_t end;
+			std::string name;
+			bool isData;
+		};
+
+		static std::shared_ptr<const SourceFile> getSourceFile(const std::string& path);
+		static void genChunk(std::string* out, const Chunk& chunk, const uint8_t* text, uint32_t textAddr, uint32_t textSize, const LineTable& lineTable, const std::vector<std::shared_ptr<const SourceFile>>& sources, const InstDecoder& decoder);
+
+		static std::mutex sourceCacheMutex;
+		static std::unordered_map<std::string, std::shared_ptr<const SourceFile>> sourceCache; // [path] = file, gets reloaded if the file changed
+	}
+}
+
+std::shared_ptr<const BinTools::SrcMix::SourceFile> BinTools::SrcMix::getSourceFile(const std::string& path) {
+	struct stat st;
+	if (stat(path.c_str(), &st) != 0)
+		return nullptr;
+
+	{
+		std::lock_guard<std::mutex> lock(sourceCacheMutex);
+		auto res = sourceCache.find(path);
+		if (res != sourceCache.end() && res->second->mtime == (int64_t)st.st_mtime && res->second->size == (uint64_t)st.st_size)
+			return res->second;
+	}
+
+	std::ifstream stream(path, std::ios::binary);
+	if (!stream)
+		return nullptr;
+
+	auto file = std::make_shared<SourceFile>();
+	file->mtime = (int64_t)st.st_mtime;
+	file->size = (uint64_t)st.st_size;
+	file->content.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+	file->lineStarts.push_back(0);
+	for (const char* ptr = file->content.c_str(), *end = ptr + file->content.size(); (ptr = (const char*)std::memchr(ptr, '\n', end - ptr)) != nullptr; ) {
+		ptr++;
+		if (ptr == end)
+			break;
+		file->lineStarts.push_back(ptr - file->content.c_str());
+	}
+
+	std::lock_guard<std::mutex> lock(sourceCacheMutex);
+	sourceCache[path] = file;
+	return file;
+}
+
+void BinTools::SrcMix::genChunk(std::string* out, const Chunk& chunk, const uint8_t* text, uint32_t textAddr, uint32_t textSize, const LineTable& lineTable, const std::vector<std::shared_ptr<const SourceFile>>& sources, const InstDecoder& decoder) {
+	constexpr uint32_t maxContextLines = 8; // if we jump forward only a few lines, show the skipped ones too (like objdump -S does)
+	char buf[128];
+
+	std::snprintf(buf, sizeof(buf), "\n%08x <%s>:\n", chunk.start, chunk.name.c_str());
+	*out += buf;
+
+	auto getByte = [&](uint32_t addr) -> uint8_t {
+		return addr - textAddr < textSize ? text[addr - textAddr] : 0;
+	};
+	auto getWord = [&](uint32_t addr) -> uint16_t {
+		return getByte(addr) | (getByte(addr + 1) << 8);
+	};
+
+	if (chunk.isData) {
+		for (uint32_t addr = chunk.start; addr < chunk.end; addr += 16) {
+			const uint32_t len = std::min<uint32_t>(16, chunk.end - addr);
+			std::snprintf(buf, sizeof(buf), "%8x:\t", addr);
+			*out += buf;
+			std::string ascii;
+			for (uint32_t i = 0; i < 16; i++) {
+				if (i < len) {
+					const uint8_t byte = getByte(addr + i);
+					std::snprintf(buf, sizeof(buf), i < 15 ? "%02x " : "%02x", byte);
+					ascii += (byte >= 0x20 && byte < 0x7F) ? (char)byte : '.';
+				}
+				else {
+					std::snprintf(buf, sizeof(buf), i < 15 ? "   " : "  ");
+				}
+				*out += buf;
+			}
+			*out += "  " + ascii + "\n";
+		}
+		return;
+	}
+
+	auto rowIt = std::lower_bound(lineTable.rows.begin(), lineTable.rows.end(), chunk.start, [](const LineTable::Row& row, uint32_t addr) {
+		return row.addr < addr;
+	});
+
+	uint32_t lastFile = (uint32_t)-1;
+	uint32_t lastLine = 0;
+	for (uint32_t addr = chunk.start; addr < chunk.end; ) {
+		// source lines, only rows exactly at the instruction are relevant
+		const LineTable::Row* row = nullptr;
+		while (rowIt != lineTable.rows.end() && rowIt->addr <= addr) {
+			if (rowIt->addr == addr)
+				row = &*rowIt;
+			rowIt++;
+		}
+		if (row && (row->file != lastFile || row->line != lastLine)) {
+			*out += lineTable.files[row->file] + ":" + std::to_string(row->line) + "\n";
+
+			const SourceFile* src = sources[row->file].get();
+			if (src) {
+				uint32_t from = row->line;
+				if (row->file == lastFile && row->line > lastLine && row->line - lastLine <= maxContextLines)
+					from = lastLine + 1;
+				for (uint32_t l = from; l <= row->line; l++) {
+					auto line = src->getLine(l);
+					if (line.first)
+						(*out += std::string(line.first, line.second)) += "\n";
+				}
+			}
+
+			lastFile = row->file;
+			lastLine = row->line;
+		}
+
+		const uint16_t word = getWord(addr);
+		uint32_t len = decoder.getInstLen(word) * 2;
+		if (len == 4 && addr + 4 <= chunk.end) {
+			const uint16_t word2 = getWord(addr + 2);
+			std::snprintf(buf, sizeof(buf), "%8x:\t%02x %02x %02x %02x \t", addr, word & 0xFF, word >> 8, word2 & 0xFF, word2 >> 8);
+			(*out += buf) += decoder.disassemble(word, word2) + "\n";
+		}
+		else if (addr + 2 <= chunk.end) {
+			len = 2;
+			std::snprintf(buf, sizeof(buf), "%8x:\t%02x %02x       \t", addr, word & 0xFF, word >> 8);
+			(*out += buf) += decoder.disassemble(word, 0) + "\n";
+		}
+		else { // odd trailing byte
+			len = 1;
+			std::snprintf(buf, sizeof(buf), "%8x:\t%02x          \t.byte\t0x%02x\n", addr, word & 0xFF, word & 0xFF);
+			*out += buf;
+		}
+		addr += len;
+	}
+}
+
+std::string BinTools::generateSrcMix(const SrcMixELF& elf, const InstDecoder& decoder) {
+	using namespace SrcMix;
+
+	if (!elf.text.data)
+		throw std::runtime_error("elf has no .text section");
+	const uint32_t textStart = elf.textAddr;
+	const uint32_t textEnd = elf.textAddr + (uint32_t)elf.text.size;
+
+	const LineTable lineTable = parseDebugLine(elf.debugLine, elf.debugLineStr, elf.debugStr);
+
+	// split .text up at every symbol, every chunk gets generated independently
+	std::vector<Chunk> chunks;
+	{
+		std::vector<SrcMixELF::Symbol> symbols;
+		for (auto& symbol : elf.symbols) {
+			if (symbol.name.size() > 0 && symbol.addr >= textStart && symbol.addr < textEnd)
+				symbols.push_back(symbol);
+		}
+
+		std::sort(symbols.begin(), symbols.end(), [&](const SrcMixELF::Symbol& a, const SrcMixELF::Symbol& b) {
+			if (a.addr != b.addr)
+				return a.addr < b.addr;
+			if (a.isData != b.isData)
+				return !a.isData; // functions first
+			return a.name < b.name;
+		});
+		symbols.erase(std::unique(symbols.begin(), symbols.end(), [](const SrcMixELF::Symbol& a, const SrcMixELF::Symbol& b) {
+			return a.addr == b.addr;
+		}), symbols.end());
+
+		if (symbols.size() == 0 || symbols[0].addr != textStart)
+			chunks.push_back({ textStart, 0, ".text", false });
+		for (auto& symbol : symbols)
+			chunks.push_back({ symbol.addr, 0, symbol.name, symbol.isData });
+		for (size_t i = 0; i < chunks.size(); i++)
+			chunks[i].end = i + 1 < chunks.size() ? chunks[i + 1].start : textEnd;
+	}
+
+	// load all needed source files up front, so the workers only read
+	std::vector<std::shared_ptr<const SourceFile>> sources(lineTable.files.size());
+	for (size_t i = 0; i < sources.size(); i++)
+		sources[i] = getSourceFile(lineTable.files[i]);
+
+	std::vector<std::string> outs(chunks.size());
+	std::atomic<size_t> nextChunk{ 0 };
+	auto work = [&] {
+		size_t i;
+		while ((i = nextChunk++) < chunks.size())
+			genChunk(&outs[i], chunks[i], elf.text.data, textStart, (uint32_t)elf.text.size, lineTable, sources, decoder);
+	};
+
+#if !defined(__EMSCRIPTEN__)
+	const size_t numThreads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), chunks.size());
+	if (numThreads > 1) {
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < numThreads; t++)
+			threads.emplace_back(work);
+		for (auto& thread : threads)
+			thread.join();
+	}
+	else
+#endif
+	{
+		work();
+	}
+
+	size_t totalLen = 0;
+	for (auto& o : outs)
+		totalLen += o.size();
+
+	std::string out;
+	out.reserve(totalLen + 64);
+	out += "\nDisassembly of section .text:\n";
+	for (auto& o : outs)
+		out += o;
+	return out;
 }
\ No newline at end of file
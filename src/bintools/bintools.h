@@ -3,12 +3,40 @@
 
 #include <vector>
 #include <string>
+#include <functional>
+#include <stdint.h>
+
+#include "dwarfLines.h"
 
 namespace BinTools {
 	bool canDemangle();
 	std::vector<std::string> demangleList(const char** strs, size_t num);
 
-	std::string generateSrcMix(const uint8_t* elfData, size_t elfDataLen);
+	struct InstDecoder {
+		std::function<std::string(uint16_t word, uint16_t word2)> disassemble; // may be called from multiple threads at once
+		std::function<uint8_t(uint16_t word)> getInstLen; // in words
+	};
+	// the parts of an elf generateSrcMix needs, the data has to stay alive during the call
+	struct SrcMixELF {
+		SectionData text;
+		uint32_t textAddr = 0;
+		SectionData debugLine;
+		SectionData debugLineStr;
+		SectionData debugStr;
+
+		struct Symbol {
+			uint32_t addr;
+			std::string name;
+			bool isData;
+		};
+		std::vector<Symbol> symbols; // split .text up into functions/data, dont need to be sorted
+	};
+	/*
+		Generates a listing like "avr-objdump -d -l -S" from the .debug_line info of the elf (no external tools needed).
+		Source files are read from the paths in the debug info (and cached), missing files just get left out.
+		Throws std::runtime_error if the debug info cant be parsed.
+	*/
+	std::string generateSrcMix(const SrcMixELF& elf, const InstDecoder& decoder);
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,319 @@
+#include "dwarfLines.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+
+namespace BinTools {
+	static std::string readStr(const uint8_t* data, size_t dataLen, size_t off) {
+		if (off >= dataLen)
+			return "";
+		const uint8_t* end = (const uint8_t*)std::memchr(data + off, 0, dataLen - off);
+		return std::string((const char*)data + off, end ? (const char*)end : (const char*)data + dataLen);
+	}
+
+	// bounds checked reader for the dwarf data
+	class DwarfReader {
+	private:
+		const uint8_t* ptr;
+		const uint8_t* end;
+	public:
+		DwarfReader(const uint8_t* start, const uint8_t* end) : ptr(start), end(end) {
+
+		}
+
+		const uint8_t* pos() const {
+			return ptr;
+		}
+		bool isAtEnd() const {
+			return ptr >= end;
+		}
+		void need(size_t amt) const {
+			if ((size_t)(end - ptr) < amt)
+				throw std::runtime_error("unexpected end of .debug_line");
+		}
+		void skip(size_t amt) {
+			need(amt);
+			ptr += amt;
+		}
+
+		uint64_t readN(size_t n) {
+			need(n);
+			uint64_t v = 0;
+			for (size_t i = 0; i < n; i++)
+				v |= (uint64_t)ptr[i] << (8 * i);
+			ptr += n;
+			return v;
+		}
+		uint8_t read8() {
+			return (uint8_t)readN(1);
+		}
+		uint16_t read16() {
+			return (uint16_t)readN(2);
+		}
+		uint32_t read32() {
+			return (uint32_t)readN(4);
+		}
+		uint64_t readULEB() {
+			uint64_t v = 0;
+			uint8_t shift = 0;
+			while (true) {
+				const uint8_t b = read8();
+				if (shift < 64)
+					v |= (uint64_t)(b & 0x7F) << shift;
+				shift += 7;
+				if (!(b & 0x80))
+					break;
+			}
+			return v;
+		}
+		int64_t readSLEB() {
+			int64_t v = 0;
+			uint8_t shift = 0;
+			uint8_t b;
+			do {
+				b = read8();
+				if (shift < 64)
+					v |= (int64_t)(b & 0x7F) << shift;
+				shift += 7;
+			} while (b & 0x80);
+			if (shift < 64 && (b & 0x40))
+				v |= -((int64_t)1 << shift);
+			return v;
+		}
+		std::string readStr() {
+			const uint8_t* strEnd = (const uint8_t*)std::memchr(ptr, 0, end - ptr);
+			if (!strEnd)
+				throw std::runtime_error("unterminated string in .debug_line");
+			std::string s((const char*)ptr, (const char*)strEnd);
+			ptr = strEnd + 1;
+			return s;
+		}
+	};
+}
+
+BinTools::LineTable BinTools::parseDebugLine(const SectionData& debugLine, const SectionData& debugLineStr, const SectionData& debugStr) {
+	LineTable table;
+
+	if (!debugLine.data)
+		return table;
+
+	auto readStrFromSection = [&](const SectionData& section, uint64_t off) -> std::string {
+		if (!section.data)
+			throw std::runtime_error("string section for .debug_line missing");
+		return readStr(section.data, section.size, (size_t)off);
+	};
+
+	DwarfReader unitReader(debugLine.data, debugLine.data + debugLine.size);
+	while (!unitReader.isAtEnd()) {
+		// header
+		uint64_t unitLength = unitReader.read32();
+		size_t offsetSize = 4;
+		if (unitLength == 0xFFFFFFFF) {
+			unitLength = unitReader.readN(8);
+			offsetSize = 8;
+		}
+		unitReader.need((size_t)unitLength);
+		const uint8_t* unitEnd = unitReader.pos() + unitLength;
+		DwarfReader reader(unitReader.pos(), unitEnd);
+		unitReader.skip((size_t)unitLength);
+
+		const uint16_t version = reader.read16();
+		if (version < 2 || version > 5)
+			throw std::runtime_error("unsupported .debug_line version " + std::to_string(version));
+
+		if (version >= 5) {
+			reader.read8(); // address_size, DW_LNE_set_address tells us the size anyways
+			reader.read8(); // segment_selector_size
+		}
+
+		const uint64_t headerLength = reader.readN(offsetSize);
+		reader.need((size_t)headerLength);
+		const uint8_t* programStart = reader.pos() + headerLength;
+
+		const uint8_t minInstLength = reader.read8();
+		if (version >= 4)
+			reader.read8(); // maximum_operations_per_instruction, only relevant for VLIW
+		reader.read8(); // default_is_stmt
+		const int8_t lineBase = (int8_t)reader.read8();
+		const uint8_t lineRange = reader.read8();
+		const uint8_t opcodeBase = reader.read8();
+		if (lineRange == 0)
+			throw std::runtime_error("invalid line_range in .debug_line");
+
+		std::vector<uint8_t> standardOpcodeLengths(opcodeBase > 0 ? opcodeBase - 1 : 0);
+		for (auto& len : standardOpcodeLengths)
+			len = reader.read8();
+
+		// directories and files
+		std::vector<std::string> dirs;
+		std::vector<uint32_t> unitFiles; // [file ind of the unit] = ind into table.files
+		auto addFile = [&](const std::string& name, uint64_t dirInd) {
+			std::string path = name;
+			const bool isAbsolute = name.size() > 0 && (name[0] == '/' || name[0] == '\\' || (name.size() > 1 && name[1] == ':'));
+			if (!isAbsolute && dirInd < dirs.size() && dirs[(size_t)dirInd].size() > 0)
+				path = dirs[(size_t)dirInd] + "/" + name;
+
+			auto it = std::find(table.files.begin(), table.files.end(), path);
+			unitFiles.push_back((uint32_t)(it - table.files.begin()));
+			if (it == table.files.end())
+				table.files.push_back(path);
+		};
+
+		if (version >= 5) {
+			enum { DW_LNCT_path = 1, DW_LNCT_directory_index = 2 };
+			auto readEntries = [&](bool isFile) {
+				std::vector<std::pair<uint64_t, uint64_t>> format; // {content type, form}
+				const uint8_t formatCount = reader.read8();
+				for (uint8_t i = 0; i < formatCount; i++) {
+					const uint64_t type = reader.readULEB();
+					const uint64_t form = reader.readULEB();
+					format.push_back({ type, form });
+				}
+
+				const uint64_t count = reader.readULEB();
+				for (uint64_t e = 0; e < count; e++) {
+					std::string path;
+					uint64_t dirInd = 0;
+					for (auto& f : format) {
+						std::string str;
+						uint64_t val = 0;
+						switch (f.second) {
+							case 0x08: str = reader.readStr(); break; // DW_FORM_string
+							case 0x1f: str = readStrFromSection(debugLineStr, reader.readN(offsetSize)); break; // DW_FORM_line_strp
+							case 0x0e: str = readStrFromSection(debugStr, reader.readN(offsetSize)); break; // DW_FORM_strp
+							case 0x0f: val = reader.readULEB(); break; // DW_FORM_udata
+							case 0x0b: val = reader.readN(1); break; // DW_FORM_data1
+							case 0x05: val = reader.readN(2); break; // DW_FORM_data2
+							case 0x06: val = reader.readN(4); break; // DW_FORM_data4
+							case 0x07: val = reader.readN(8); break; // DW_FORM_data8
+							case 0x1e: reader.skip(16); break; // DW_FORM_data16 (MD5)
+							case 0x09: reader.skip((size_t)reader.readULEB()); break; // DW_FORM_block
+							default:
+								throw std::runtime_error("unsupported form in .debug_line header: " + std::to_string(f.second));
+						}
+
+						if (f.first == DW_LNCT_path)
+							path = str;
+						else if (f.first == DW_LNCT_directory_index)
+							dirInd = val;
+					}
+
+					if (isFile)
+						addFile(path, dirInd);
+					else
+						dirs.push_back(path);
+				}
+			};
+			readEntries(false);
+			readEntries(true);
+		}
+		else {
+			dirs.push_back(""); // dir 0 is the compilation dir, which isnt part of the line table
+			while (true) {
+				std::string dir = reader.readStr();
+				if (dir.size() == 0)
+					break;
+				dirs.push_back(dir);
+			}
+
+			unitFiles.push_back((uint32_t)-1); // file inds start at 1
+			while (true) {
+				std::string name = reader.readStr();
+				if (name.size() == 0)
+					break;
+				const uint64_t dirInd = reader.readULEB();
+				reader.readULEB(); // mtime
+				reader.readULEB(); // length
+				addFile(name, dirInd);
+			}
+		}
+
+		// the line number program
+		reader = DwarfReader(programStart, unitEnd);
+
+		uint64_t addr = 0;
+		uint64_t file = 1;
+		int64_t line = 1;
+		auto resetRegs = [&] {
+			addr = 0;
+			file = 1;
+			line = 1;
+		};
+		auto emitRow = [&] {
+			if (file < unitFiles.size() && unitFiles[(size_t)file] != (uint32_t)-1 && line > 0)
+				table.rows.push_back({ (uint32_t)addr, unitFiles[(size_t)file], (uint32_t)line });
+		};
+
+		while (!reader.isAtEnd()) {
+			const uint8_t opcode = reader.read8();
+			if (opcode >= opcodeBase) { // special opcode
+				const uint8_t adj = opcode - opcodeBase;
+				addr += (adj / lineRange) * minInstLength;
+				line += lineBase + (adj % lineRange);
+				emitRow();
+				continue;
+			}
+
+			switch (opcode) {
+				case 0: { // extended opcode
+					const uint64_t len = reader.readULEB();
+					if (len == 0)
+						break;
+					const uint8_t* extEnd = reader.pos() + len;
+					reader.need((size_t)len);
+					const uint8_t subOp = reader.read8();
+					switch (subOp) {
+						case 1: // DW_LNE_end_sequence
+							// no row: the end address is one past the sequence, usually the start of the next function
+							resetRegs();
+							break;
+						case 2: // DW_LNE_set_address
+							addr = reader.readN(std::min<size_t>((size_t)len - 1, 8));
+							break;
+						case 3: { // DW_LNE_define_file (DWARF <= 4)
+							std::string name = reader.readStr();
+							const uint64_t dirInd = reader.readULEB();
+							reader.readULEB();
+							reader.readULEB();
+							addFile(name, dirInd);
+							break;
+						}
+						default: // DW_LNE_set_discriminator and vendor extensions
+							break;
+					}
+					reader = DwarfReader(extEnd, unitEnd);
+					break;
+				}
+				case 1: // DW_LNS_copy
+					emitRow();
+					break;
+				case 2: // DW_LNS_advance_pc
+					addr += reader.readULEB() * minInstLength;
+					break;
+				case 3: // DW_LNS_advance_line
+					line += reader.readSLEB();
+					break;
+				case 4: // DW_LNS_set_file
+					file = reader.readULEB();
+					break;
+				case 8: // DW_LNS_const_add_pc
+					addr += ((255 - opcodeBase) / lineRange) * minInstLength;
+					break;
+				case 9: // DW_LNS_fixed_advance_pc
+					addr += reader.read16();
+					break;
+				default: // the other standard opcodes only change registers we dont care about, so we skip their arguments
+					for (uint8_t i = 0; i < standardOpcodeLengths[opcode - 1]; i++)
+						reader.readULEB();
+					break;
+			}
+		}
+	}
+
+	std::stable_sort(table.rows.begin(), table.rows.end(), [](const LineTable::Row& a, const LineTable::Row& b) {
+		return a.addr < b.addr;
+	});
+
+	return table;
+}
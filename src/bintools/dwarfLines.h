@@ -0,0 +1,29 @@
+#ifndef _ABB_BINTOOLS_DWARFLINES_H
+#define _ABB_BINTOOLS_DWARFLINES_H
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+namespace BinTools {
+	// contents of an elf section, empty if the elf doesnt have it
+	struct SectionData {
+		const uint8_t* data = nullptr;
+		size_t size = 0;
+	};
+
+	// the line number program of .debug_line (DWARF 2 to 5)
+	struct LineTable {
+		struct Row {
+			uint32_t addr;
+			uint32_t file; // ind into files
+			uint32_t line;
+		};
+		std::vector<std::string> files;
+		std::vector<Row> rows; // sorted by addr
+	};
+	// debugLineStr and debugStr are only needed for DWARF 5, throws std::runtime_error on malformed data
+	LineTable parseDebugLine(const SectionData& debugLine, const SectionData& debugLineStr, const SectionData& debugStr);
+}
+
+#endif
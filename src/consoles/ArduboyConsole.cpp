@@ -166,6 +166,74 @@ ABB::Console::pc_t ABB::ArduboyConsole::disassembler_getJumpDests(uint16_t word,
 std::string ABB::ArduboyConsole::disassembler_disassembleRaw(uint16_t word, uint16_t word2) {
 	return A32u4::Disassembler::disassembleRaw(word, word2);
 }
+static uint8_t getInstCycles(uint16_t word) {
+	// cycle counts of the ATmega32u4 (16 bit PC)
+	switch (word & 0xF000) {
+		case 0xC000: return 2; // RJMP
+		case 0xD000: return 3; // RCALL
+	}
+	if ((word & 0xD000) == 0x8000) return 2; // LD(D)/ST(D) Y/Z (+q)
+
+	switch (word & 0xFF00) {
+		case 0x0200: // MULS
+		case 0x0300: // MULSU, FMUL, FMULS, FMULSU
+		case 0x9600: // ADIW
+		case 0x9700: // SBIW
+		case 0x9800: // CBI
+		case 0x9A00: // SBI
+			return 2;
+	}
+	if ((word & 0xFC00) == 0x9C00) return 2; // MUL
+
+	switch (word & 0xFE0F) {
+		case 0x9004: case 0x9005: // LPM Z, Z+
+		case 0x9006: case 0x9007: // ELPM Z, Z+
+			return 3;
+		case 0x9000: case 0x9001: case 0x9002: // LDS, LD Z+, LD -Z
+		case 0x9009: case 0x900A:              // LD Y+, LD -Y
+		case 0x900C: case 0x900D: case 0x900E: // LD X, X+, -X
+		case 0x900F:                           // POP
+		case 0x9200: case 0x9201: case 0x9202: // STS, ST Z+, ST -Z
+		case 0x9209: case 0x920A:              // ST Y+, ST -Y
+		case 0x920C: case 0x920D: case 0x920E: // ST X, X+, -X
+		case 0x920F:                           // PUSH
+			return 2;
+		case 0x940C: case 0x940D: // JMP
+			return 3;
+		case 0x940E: case 0x940F: // CALL
+			return 4;
+	}
+
+	switch (word) {
+		case 0x9409: case 0x9419: return 2; // IJMP, EIJMP
+		case 0x9509: return 3; // ICALL
+		case 0x9519: return 4; // EICALL
+		case 0x9508: case 0x9518: return 4; // RET, RETI
+		case 0x95C8: case 0x95D8: return 3; // LPM, ELPM
+	}
+
+	return 1;
+}
+static bool isTwoWordInst(uint16_t word) {
+	switch (word & 0xFE0F) {
+		case 0x9000: case 0x9200: // LDS, STS
+		case 0x940C: case 0x940D: // JMP
+		case 0x940E: case 0x940F: // CALL
+			return true;
+	}
+	return false;
+}
+uint8_t ABB::ArduboyConsole::disassembler_getInstCycles(uint16_t word) {
+	return getInstCycles(word);
+}
+bool ABB::ArduboyConsole::disassembler_isCall(uint16_t word) {
+	return (word & 0xF000) == 0xD000 // RCALL
+		|| (word & 0xFE0E) == 0x940E // CALL
+		|| word == 0x9509 || word == 0x9519; // ICALL, EICALL
+}
+uint8_t ABB::ArduboyConsole::disassembler_getInstLen(uint16_t word) {
+	return isTwoWordInst(word) ? 2 : 1;
+}
 std::string ABB::ArduboyConsole::disassembler_disassembleProg(
 	const std::vector<std::pair<uint32_t, std::string>>* srcLines,
 	const std::vector<std::pair<uint32_t, std::string>>* funcSymbs,
@@ -244,40 +312,65 @@ uint64_t ABB::ArduboyConsole::analytics_getPCHeat(pc_t pc) const {
 uint64_t ABB::ArduboyConsole::analytics_getInstHeat(size_t ind) const {
 	return ab.mcu.analytics.getInstHeat()[ind];
 }
+uint64_t ABB::ArduboyConsole::analytics_getPCCycles(pc_t pc) const {
+	const uint64_t* pcCnt = ab.mcu.analytics.getPCCntRaw();
+	const uint64_t cnt = pcCnt[pc];
+	if (cnt == 0)
+		return 0;
 
-ABB::Console::ParamInfo ABB::ArduboyConsole::getParamInfo(const char* start, const char* end, const char* instStart, const char* instEnd, uint32_t pcAddr) const {
+	constexpr size_t numPCs = A32u4::Flash::sizeMax / 2;
+	const A32u4::Flash& flash = ab.mcu.flash;
+	auto getWord = [&](size_t p) -> uint16_t {
+		return p < numPCs ? (flash.getByte((addrmcu_t)(p*2)) | (flash.getByte((addrmcu_t)(p*2+1)) << 8)) : 0;
+	};
+	const uint16_t word = getWord(pc);
+
+	uint64_t cycs = cnt * getInstCycles(word);
+
+	// the core only counts executions, so how often a branch was taken (or an instruction was skipped)
+	// is derived from how often the following instruction was executed. This is only an estimate:
+	// if the following instruction is also a jump target, its count includes those jumps and the
+	// extra cycles get undercounted
+	const uint64_t nextCnt = (size_t)pc+1 < numPCs ? pcCnt[pc+1] : 0;
+	const uint64_t notFallenThrough = cnt > nextCnt ? cnt - nextCnt : 0;
+	if ((word & 0xF800) == 0xF000) { // BRBS, BRBC
+		cycs += notFallenThrough;
+	}
+	else if ((word & 0xFC00) == 0x1000 || (word & 0xFC08) == 0xFC00 || (word & 0xFD00) == 0x9900) { // CPSE, SBRC/SBRS, SBIC/SBIS
+		cycs += notFallenThrough * (isTwoWordInst(getWord((size_t)pc+1)) ? 2 : 1);
+	}
+
+	return cycs;
+}
+const uint64_t* ABB::ArduboyConsole::analytics_getRamReads() {
+	return ab.mcu.analytics.getRamRead();
+}
+const uint64_t* ABB::ArduboyConsole::analytics_getRamWrites() {
+	return ab.mcu.analytics.getRamWrite();
+}
+void ABB::ArduboyConsole::analytics_resetRamReadsWrites() {
+	ab.mcu.analytics.clearRamRead();
+	ab.mcu.analytics.clearRamWrite();
+}
+
+ABB::Console::ParamInfo ABB::ArduboyConsole::disassembler_parseParam(const char* start, const char* end, const char* instStart, const char* instEnd, uint32_t pcAddr) const {
 	size_t len = end - start;
+	if (len == 0)
+		return { ParamType_None, 0 };
 
 	switch (start[0]) {
 		case 'R':
 		case 'r': {
 			regind_t ind = StringUtils::numBaseStrToUIntT<10, regind_t>(start + 1, end);
-			return {ParamType_Register, ab.mcu.dataspace.getGPReg(ind)};
+			return {ParamType_Register, ind};
 		}
 
 		case 'X':
+			return {ParamType_RamAddrRegister, 26};
 		case 'Y':
+			return {ParamType_RamAddrRegister, 28};
 		case 'Z':
-		{
-			bool isRam = false;
-			uint16_t regVal = -1;
-			switch (start[0]) {
-				case 'X':
-					regVal = ab.mcu.dataspace.getX();
-					isRam = true;
-					break;
-				case 'Y':
-					regVal = ab.mcu.dataspace.getY();
-					isRam = true;
-					break;
-				case 'Z':
-					regVal = ab.mcu.dataspace.getZ();
-					isRam = true;
-					break;
-			}
-
-			return {(uint8_t)(isRam ? ParamType_RamAddrRegister : ParamType_RomAddrRegister), regVal};
-		}
+			return {ParamType_RamAddrRegister, 30};
 
 		case '0': {
 			if(len > 1 && start[1] == 'x'){
@@ -322,8 +415,12 @@ ABB::Console::ParamInfo ABB::ArduboyConsole::getParamInfo(const char* start, con
 			}
 		} break;
 
-		case '.': {
-			int32_t rawVal = std::stoi(std::string(start+1,end));
+		case '.': { // relative jump like ".+12" or ".-4"
+			if (len < 3 || (start[1] != '+' && start[1] != '-'))
+				break;
+			int32_t rawVal = (int32_t)StringUtils::numBaseStrToUIntT<10, uint32_t>(start + 2, end);
+			if (start[1] == '-')
+				rawVal = -rawVal;
 			uint32_t val = rawVal + pcAddr;
 
 			return {ParamType_RomAddr, val};
@@ -340,6 +437,22 @@ ABB::Console::ParamInfo ABB::ArduboyConsole::getParamInfo(const char* start, con
 
 	return { ParamType_None, 0 };
 }
+ABB::Console::ParamInfo ABB::ArduboyConsole::getParamInfo(const ParamInfo& param) const {
+	switch (param.type) {
+		case ParamType_Register:
+			return {param.type, ab.mcu.dataspace.getGPReg((regind_t)param.val)};
+
+		case ParamType_RamAddrRegister:
+		case ParamType_RomAddrRegister:
+			switch (param.val) {
+				case 26: return {param.type, ab.mcu.dataspace.getX()};
+				case 28: return {param.type, ab.mcu.dataspace.getY()};
+				case 30: return {param.type, ab.mcu.dataspace.getZ()};
+			}
+			break;
+	}
+	return param;
+}
 void ABB::ArduboyConsole::draw_stateInfo() {
 	uint8_t sreg_val = ab.mcu.dataspace.getDataByte(A32u4::DataSpace::Consts::SREG);
 	constexpr const char* bitNames[] = {"I","T","H","S","V","N","Z","C"};
@@ -374,11 +487,7 @@ ABB::Console::Hex ABB::ArduboyConsole::getHexViewer(size_t ind) {
 			[=](const uint8_t* data_, size_t len) {
 			ab.mcu.dataspace.loadDataFromMemory(data_, len);
 		},
-			ab.mcu.analytics.getRamRead(), ab.mcu.analytics.getRamWrite(),
-			[=]() {
-			ab.mcu.analytics.clearRamRead();
-			ab.mcu.analytics.clearRamWrite();
-		}
+			ab.mcu.analytics.getRamRead(), ab.mcu.analytics.getRamWrite()
 		};
 		case 1: return Hex{"Eeprom",    ab.mcu.dataspace.getEEPROM(), A32u4::DataSpace::Consts::eeprom_size, Hex::Type_None, 
 			[=](addrmcu_t addr, uint8_t val) {
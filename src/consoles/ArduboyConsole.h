@@ -75,6 +75,9 @@ namespace ABB {
 		// Disassembler
 		virtual pc_t disassembler_getJumpDests(uint16_t word, uint16_t word2, pc_t pc) override;
 		virtual std::string disassembler_disassembleRaw(uint16_t word, uint16_t word2) override;
+		virtual uint8_t disassembler_getInstCycles(uint16_t word) override;
+		virtual bool disassembler_isCall(uint16_t word) override;
+		virtual uint8_t disassembler_getInstLen(uint16_t word) override;
 		virtual std::string disassembler_disassembleProg(
 			const std::vector<std::pair<uint32_t, std::string>>* srcLines = nullptr,
 			const std::vector<std::pair<uint32_t, std::string>>* funcSymbs = nullptr,
@@ -105,10 +108,15 @@ namespace ABB {
 		virtual void analytics_setSleepSum(uint64_t val) override;
 		virtual void analytics_resetPCHeat() override;
 		virtual uint64_t analytics_getPCHeat(pc_t pc) const override;
+		virtual uint64_t analytics_getPCCycles(pc_t pc) const override;
 		virtual uint64_t analytics_getInstHeat(size_t ind) const override;
+		virtual const uint64_t* analytics_getRamReads() override;
+		virtual const uint64_t* analytics_getRamWrites() override;
+		virtual void analytics_resetRamReadsWrites() override;
 
 
-		virtual ParamInfo getParamInfo(const char* start, const char* end, const char* instStart, const char* instEnd, uint32_t pcAddr) const override;
+		virtual ParamInfo disassembler_parseParam(const char* start, const char* end, const char* instStart, const char* instEnd, uint32_t pcAddr) const override;
+		virtual ParamInfo getParamInfo(const ParamInfo& param) const override;
 
 		virtual void draw_stateInfo() override;
 
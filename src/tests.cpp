@@ -5,6 +5,10 @@
 #include <vector>
 #include <array>
 #include <random>
+#include <cstring>
+#include <memory>
+#include <algorithm>
+#include <functional>
 
 #include "StreamUtils.h"
 #include "StringUtils.h"
@@ -13,6 +17,11 @@
 #include "Arduboy.h"
 #include "ElfReader.h"
 
+#include "consoles/ArduboyConsole.h"
+#include "utils/DisasmFile.h"
+#include "utils/symbolIndex.h"
+#include "utils/hexLoader.h"
+
 
 #define ROOTDIR "./"
 
@@ -247,6 +256,220 @@ bool fuzzTest() {
     return numWorked == testFiles.size();
 }
 
+std::unique_ptr<ABB::Console> genEmu_ARDUBOY(); // from ArduboyConsole.cpp
+
+// checks that no overlapping visible branches with different destinations share a lane
+static bool checkBranchLayout(const ABB::DisasmFile& file) {
+    for (size_t i = 0; i < file.branchRoots.size(); i++) {
+        const auto& a = file.branchRoots[i];
+        if (a.displayDepth == (size_t)-3)
+            continue;
+        for (size_t j = i+1; j < file.branchRoots.size(); j++) {
+            const auto& b = file.branchRoots[j];
+            if (b.displayDepth != a.displayDepth || b.destLine == a.destLine)
+                continue;
+
+            const size_t aFrom = std::min(a.startLine, a.destLine), aTo = std::max(a.startLine, a.destLine);
+            const size_t bFrom = std::min(b.startLine, b.destLine), bTo = std::max(b.startLine, b.destLine);
+            if (aFrom <= bTo && bFrom <= aTo)
+                return false;
+        }
+    }
+    return true;
+}
+
+static std::vector<std::string> getTestFiles(const char* ext) {
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < testFiles.size(); i++) {
+        if (std::strcmp(StringUtils::getFileExtension(testFiles[i]), ext) == 0)
+            paths.push_back(testFiles[i]);
+    }
+    return paths;
+}
+
+bool benchmarkBranchLayout() {
+    constexpr size_t iterations = 20;
+    bool worked = true;
+    const std::vector<ABB::utils::IntelHex::LoadedFile> hexFiles = ABB::utils::IntelHex::loadFiles(getTestFiles("hex"), genEmu_ARDUBOY()->flash_size());
+    for (auto& hex : hexFiles) {
+        if (hex.error.size() > 0) {
+            printf("%s: %s\n", hex.path.c_str(), hex.error.c_str());
+            worked = false;
+            continue;
+        }
+
+        std::unique_ptr<ABB::Console> cons = genEmu_ARDUBOY();
+        cons->flash_loadFromMemory(hex.data.size() ? hex.data.data() : nullptr, hex.data.size());
+        const std::string disasm = cons->disassembler_disassembleProg();
+
+        ABB::DisasmFile file;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (size_t it = 0; it < iterations; it++) {
+            file.loadSrc(cons.get(), disasm.c_str(), disasm.c_str() + disasm.size());
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        double ms = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0 / iterations;
+
+        const bool layoutOk = checkBranchLayout(file);
+        worked = worked && layoutOk;
+        printf("%-60s %8" CU_PRIuSIZE " lines %6" CU_PRIuSIZE " branches %4" CU_PRIuSIZE " depth => %10.4fms %s\n",
+            hex.path.c_str(), file.getNumLines(), file.branchRoots.size(), file.maxBranchDisplayDepth, ms, layoutOk ? "ok" : "WRONG"
+        );
+    }
+    return worked;
+}
+
+bool benchmarkSymbolIndex() {
+    typedef EmuUtils::SymbolTable::symb_size_t addr_t;
+    typedef ABB::utils::SymbolIndex::Intervals Intervals;
+    constexpr size_t iterations = 20;
+
+    bool worked = true;
+    for (size_t i = 0; i < testFiles.size(); i++) {
+        if (std::strcmp(StringUtils::getFileExtension(testFiles[i]), "elf") != 0)
+            continue;
+
+        EmuUtils::SymbolTable table;
+        try {
+            std::vector<uint8_t> content = StringUtils::loadFileIntoByteArray(testFiles[i]);
+            table.loadFromELF(EmuUtils::ELF::parseELFFile(&content[0], content.size()));
+        }
+        catch (const std::runtime_error& e) {
+            printf("%s: %s\n", testFiles[i], e.what());
+            worked = false;
+            continue;
+        }
+
+        for (int isRam = 0; isRam < 2; isRam++) {
+            const EmuUtils::SymbolTable::SymbolList& list = isRam ? table.getSymbolsRam() : table.getSymbolsRom();
+            addr_t maxAddr = 0;
+            for (size_t s = 0; s < list.size(); s++)
+                maxAddr = std::max(maxAddr, table.getSymbol(list, s)->addrEnd());
+            maxAddr += 64;
+
+            auto start = std::chrono::high_resolution_clock::now();
+            for (size_t it = 0; it < iterations; it++) {
+                Intervals::build(table, list);
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            const double buildMs = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0 / iterations;
+
+            const Intervals intervals = Intervals::build(table, list);
+
+            size_t mismatches = 0;
+            for (addr_t addr = 0; addr < maxAddr; addr++) {
+                const auto* interval = intervals.find(addr);
+                if (table.getSymbolByValue(addr, list) != (interval ? interval->symbol : nullptr))
+                    mismatches++;
+            }
+
+            size_t sink = 0;
+            start = std::chrono::high_resolution_clock::now();
+            for (size_t it = 0; it < iterations; it++) {
+                for (addr_t addr = 0; addr < maxAddr; addr++)
+                    sink += (size_t)table.getSymbolByValue(addr, list);
+            }
+            end = std::chrono::high_resolution_clock::now();
+            const double tableMs = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0 / iterations;
+
+            start = std::chrono::high_resolution_clock::now();
+            for (size_t it = 0; it < iterations; it++) {
+                for (addr_t addr = 0; addr < maxAddr; addr++) {
+                    const auto* interval = intervals.find(addr);
+                    sink += (size_t)(interval ? interval->symbol : nullptr);
+                }
+            }
+            end = std::chrono::high_resolution_clock::now();
+            const double findMs = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0 / iterations;
+
+            start = std::chrono::high_resolution_clock::now();
+            for (size_t it = 0; it < iterations; it++) {
+                Intervals::Cursor cursor(&intervals);
+                for (addr_t addr = 0; addr < maxAddr; addr++)
+                    sink += (size_t)cursor.getSymbol(addr);
+            }
+            end = std::chrono::high_resolution_clock::now();
+            const double cursorMs = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0 / iterations;
+
+            // overlapping symbols may resolve differently, so mismatches are only reported
+            printf("%-60s %s %6" CU_PRIuSIZE " symbols => table: %9.4fms index: %9.4fms cursor: %9.4fms build: %8.4fms (%" CU_PRIuSIZE " mismatches) [%" CU_PRIuSIZE "]\n",
+                testFiles[i], isRam ? "RAM" : "ROM", list.size(), tableMs, findMs, cursorMs, buildMs, mismatches, sink & 0xF
+            );
+        }
+    }
+    return worked;
+}
+
+bool benchmarkHexLoading() {
+    constexpr size_t iterations = 50;
+    const size_t flashSize = genEmu_ARDUBOY()->flash_size();
+    const std::vector<std::string> paths = getTestFiles("hex");
+
+    bool worked = true;
+    std::vector<uint8_t> buf(flashSize);
+    for (auto& path : paths) {
+        std::vector<uint8_t> ref;
+        size_t len = 0;
+        double oldMs = 0, newMs = 0;
+        try {
+            auto start = std::chrono::high_resolution_clock::now();
+            for (size_t it = 0; it < iterations; it++) {
+                std::string content = StringUtils::loadFileIntoString(path.c_str());
+                ref = StringUtils::parseHexFileStr(content.c_str(), content.c_str() + content.size());
+            }
+            auto mid = std::chrono::high_resolution_clock::now();
+            for (size_t it = 0; it < iterations; it++) {
+                std::fill(buf.begin(), buf.end(), 0);
+                len = ABB::utils::IntelHex::decodeFile(path.c_str(), buf.data(), buf.size());
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            oldMs = std::chrono::duration_cast<std::chrono::microseconds>(mid - start).count() / 1000.0 / iterations;
+            newMs = std::chrono::duration_cast<std::chrono::microseconds>(end - mid).count() / 1000.0 / iterations;
+        }
+        catch (const std::runtime_error& e) {
+            printf("%s: %s\n", path.c_str(), e.what());
+            worked = false;
+            continue;
+        }
+
+        const bool same = len == ref.size() && std::memcmp(buf.data(), ref.data(), len) == 0;
+        worked = worked && same;
+        printf("%-60s %6" CU_PRIuSIZE " bytes => parseHexFileStr %8.4fms IntelHex %8.4fms %s\n",
+            path.c_str(), len, oldMs, newMs, same ? "ok" : "WRONG"
+        );
+    }
+
+    size_t numFailed = 0;
+    auto benchParallel = [&](const char* name, const std::function<std::vector<ABB::utils::IntelHex::LoadedFile>()>& load) {
+        std::vector<ABB::utils::IntelHex::LoadedFile> files;
+        auto start = std::chrono::high_resolution_clock::now();
+        try {
+            files = load();
+        }
+        catch (const std::runtime_error& e) {
+            printf("%s: %s\n", name, e.what());
+            numFailed++;
+            return;
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        for (auto& file : files) {
+            if (file.error.size() > 0) {
+                printf("%s: %s\n", file.path.c_str(), file.error.c_str());
+                numFailed++;
+            }
+        }
+        printf("%s: %" CU_PRIuSIZE " files => %8.4fms\n",
+            name, files.size(), std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0
+        );
+    };
+    benchParallel("loadFiles", [&] {
+        return ABB::utils::IntelHex::loadFiles(paths, flashSize);
+    });
+    benchParallel("loadDirectory", [&] {
+        return ABB::utils::IntelHex::loadDirectory(ROOTDIR "resources/games", flashSize);
+    });
+    return worked && numFailed == 0;
+}
 
 int test(int argc, char** argv) {
     CU_UNUSED(argc);
@@ -255,5 +478,8 @@ int test(int argc, char** argv) {
     benchmark();
     //worked = serialisationTest() && worked;
     //worked = fuzzTest() && worked;
+    //worked = benchmarkBranchLayout() && worked;
+    //worked = benchmarkSymbolIndex() && worked;
+    //worked = benchmarkHexLoading() && worked;
     return !worked;
 }
\ No newline at end of file
@@ -1,6 +1,13 @@
 #include "DisasmFile.h"
 
 #include <chrono>
+#include <unordered_map>
+#include <algorithm>
+#include <set>
+#include <queue>
+#include <functional>
+#include <cstring>
+#include <cstdio>
 
 #include "StringUtils.h"
 #include "DataUtils.h"
@@ -9,21 +16,69 @@
 
 
 #define LU_MODULE "DisasmFile"
+#define LU_CONTEXT (loadCtrl->logContext)
+
+// loading might happen on a worker thread, so we use the log context given by the load if there is one
+#define DF_LOGF(level, ...) do { \
+		if (loadCtrl && loadCtrl->logContext.first) { LU_LOGF(level, __VA_ARGS__); } \
+		else { LU_LOGF_(level, __VA_ARGS__); } \
+	} while(0)
 
 size_t ABB::DisasmFile::BranchRoot::addrDist() const {
 	return std::max(start,dest) - std::min(start,dest);
 }
 
-void ABB::DisasmFile::loadSrc(Console* cons, const char* str, const char* strEnd) {
+bool ABB::DisasmFile::loadSrc(Console* cons, const char* str, const char* strEnd, LoadControl* ctrl) {
 	if (strEnd == NULL)
 		strEnd = str + std::strlen(str);
 
-	content = std::string(str, strEnd);
-	processContent(cons);
+	loadCtrl = ctrl;
+	mappedContent = nullptr;
+	mappedContentLen = 0;
+	ownedContent = std::string(str, strEnd);
+	bool done = processContent(cons);
+	if (done)
+		updateLoadProgress(1);
+	loadCtrl = nullptr;
+	return done;
+}
+bool ABB::DisasmFile::loadMapped(Console* cons, std::shared_ptr<const utils::MappedFile> file, size_t len, LoadControl* ctrl) {
+	loadCtrl = ctrl;
+	ownedContent.clear();
+	ownedContent.shrink_to_fit();
+	mappedContentLen = std::min(len, file->size());
+	mappedContent = std::move(file);
+	bool done = processContent(cons);
+	if (done) {
+		ownedContent.assign(mappedContent->data(), mappedContentLen);
+		updateLoadProgress(1);
+	}
+	mappedContent = nullptr;
+	mappedContentLen = 0;
+	loadCtrl = nullptr;
+	return done;
+}
+
+const char* ABB::DisasmFile::getContent() const {
+	return mappedContent ? mappedContent->data() : ownedContent.c_str();
+}
+size_t ABB::DisasmFile::getContentSize() const {
+	return mappedContent ? mappedContentLen : ownedContent.size();
+}
+
+bool ABB::DisasmFile::updateLoadProgress(float progress) {
+	if (!loadCtrl)
+		return true;
+
+	loadCtrl->progress = loadCtrl->progressFrom + (loadCtrl->progressTo - loadCtrl->progressFrom) * progress;
+	return !loadCtrl->cancel;
 }
 
 uint16_t ABB::DisasmFile::getAddrFromLine(const char* start, const char* end) {
-	if (start + 8 > end || *start != ' ' || start[8] != ':') {
+	if (end - start < 9) // content might not be null terminated, so we cant look past the end
+		return Addrs_notAnAddr;
+
+	if (*start != ' ' || start[8] != ':') {
 		if (*start == '0' && start[8] == ' ' && isValidHexAddr(start,start+8))
 			return Addrs_symbolLabel;
 		else
@@ -73,435 +128,1167 @@ void ABB::DisasmFile::addAddrToList(const char* start, const char* end, size_t l
 	}
 }
 
-void ABB::DisasmFile::processBranches(Console* cons) {
+bool ABB::DisasmFile::getBranchRootOfLine(Console* cons, size_t line, BranchRoot* branchRoot, Console::addrmcu_t* missingDest) const {
+	Console::addrmcu_t addr = addrs[line];
+	if (!isLineProgram[line] || addr == Addrs_notAnAddr || addr == Addrs_symbolLabel)
+		return false;
+
+	Console::addrmcu_t dest;
+	// get dest address
+	{
+		const char* lineStart = getContent() + lines[line];
+
+		uint16_t word = ( StringUtils::hexStrToUIntLen<uint16_t>(lineStart+FileConsts::instBytesStart,   2)) |
+			( StringUtils::hexStrToUIntLen<uint16_t>(lineStart+FileConsts::instBytesStart+3, 2) << 8);
+		uint16_t word2 = 0;
+		if(*(lineStart+FileConsts::instBytesStart+3+3) != ' ') {
+			word2 =		( StringUtils::hexStrToUIntLen<uint16_t>(lineStart+FileConsts::instBytesStart+3+3,   2)) |
+				( StringUtils::hexStrToUIntLen<uint16_t>(lineStart+FileConsts::instBytesStart+3+3+3, 2) << 8);
+		}
+
+		Console::pc_t destPC = cons->disassembler_getJumpDests(word,word2,addr/2);
+		if (destPC == (Console::pc_t)-1)
+			return false; // instruction doesn't jump anywhere
+		dest = destPC * 2;
+	}
+
+	size_t destLine = getLineIndFromAddr(dest);
+
+	if (destLine == (decltype(destLine))-1 || addrs[destLine] != dest) { // for whatever reason, sometimes programs have illegal jumps like negative addresses or into data
+		if (missingDest)
+			*missingDest = dest;
+		return false;
+	}
+
+	branchRoot->start = addr;
+	branchRoot->dest = dest;
+	branchRoot->startLine = line;
+	branchRoot->destLine = destLine;
+	branchRoot->displayDepth = -1;
+	return true;
+}
+
+bool ABB::DisasmFile::processBranches(Console* cons) {
 	maxBranchDisplayDepth = 0;
 	branchRoots.clear();
 	branchRootInds.clear();
+	unresolvedBranches.clear();
 
 	branchRootInds.resize(lines.size(), -1);
 
 	{
 		auto start0 = std::chrono::high_resolution_clock::now();
-		std::vector<std::vector<size_t>> passingBranches(lines.size()); // raw representation, that later gets compressed into passingBranchesInds and passingBranchesVec; [lineno] = vector of inds of passing branches
 		for (size_t i = 0; i < lines.size(); i++) {
+			if (i % 4096 == 0 && !updateLoadProgress(0.1f + 0.5f * i / lines.size()))
+				return false;
+
 			if (!isLineProgram[i])
 				continue;
 
-			Console::addrmcu_t addr = addrs[i];
-			if (addr != Addrs_notAnAddr && addr != Addrs_symbolLabel) {
-				Console::addrmcu_t dest;
-				// get dest address
-				{
-					const char* lineStart = content.c_str() + lines[i];
-					//const char* line_end = content.c_str() + ((i + 1 < lines.size()) ? lines[i] : content.size());
-
-					uint16_t word = ( StringUtils::hexStrToUIntLen<uint16_t>(lineStart+FileConsts::instBytesStart,   2)) |
-						( StringUtils::hexStrToUIntLen<uint16_t>(lineStart+FileConsts::instBytesStart+3, 2) << 8);
-					uint16_t word2 = 0;
-					if(*(lineStart+FileConsts::instBytesStart+3+3) != ' ') {
-						word2 =		( StringUtils::hexStrToUIntLen<uint16_t>(lineStart+FileConsts::instBytesStart+3+3,   2)) |
-							( StringUtils::hexStrToUIntLen<uint16_t>(lineStart+FileConsts::instBytesStart+3+3+3, 2) << 8);
-					}
-
-					Console::pc_t destPC = cons->disassembler_getJumpDests(word,word2,addr/2);
-					if (destPC == (Console::pc_t)-1)
-						continue; // instruction doesn't jump anywhere
-					dest = destPC * 2;
-				}
-
-				size_t destLine = getLineIndFromAddr(dest);
-
-				if (destLine == (decltype(destLine))-1 || addrs[destLine]%2 == 1) // for whatever reason, sometimes programs have illegal jumps like negative addresses or odd addresses
-					continue;
-
-				DU_ASSERT(addrs[destLine] == dest);
-
-				size_t branchRootInd = branchRoots.size();
-				branchRootInds[i] = branchRootInd;
-
-				branchRoots.push_back(BranchRoot());
-				BranchRoot& branchRoot = branchRoots.back();
-				branchRoot.start = addr;
-				branchRoot.dest = dest;
-				branchRoot.startLine = i;
-				branchRoot.destLine = destLine;
-
-
-
-				size_t from = std::min(i, destLine);
-				size_t to = std::max(i, destLine);
-
-				for (size_t l = from; l <= to; l++) {
-					auto& passing = passingBranches[l];
-					passing.push_back(branchRootInd);
-				}
-
-				branchRoot.displayDepth = -1;
+			BranchRoot branchRoot;
+			Console::addrmcu_t missingDest = Addrs_notAnAddr;
+			if (!getBranchRootOfLine(cons, i, &branchRoot, &missingDest)) {
+				if (missingDest != Addrs_notAnAddr)
+					unresolvedBranches.push_back({ i, missingDest });
+				continue;
 			}
+
+			branchRootInds[i] = branchRoots.size();
+			branchRoots.push_back(branchRoot);
 		}
 		auto end0 = std::chrono::high_resolution_clock::now();
 
 		{
 			double ms = std::chrono::duration_cast<std::chrono::microseconds>(end0 - start0).count()/1000.0;
-			LU_LOGF_(LogUtils::LogLevel_DebugOutput, "branch init took: %f ms", ms);
+			DF_LOGF(LogUtils::LogLevel_DebugOutput, "branch init took: %f ms", ms);
 		}
+	}
 
+	if (!updateLoadProgress(0.6f))
+		return false;
 
-		// now we compress passingBranches into passingBranchesInds and passingBranchesVec
-
-		auto start1 = std::chrono::high_resolution_clock::now();
-
-		passingBranchesInds.clear();
-		passingBranchesVec.clear();
-		passingBranchesInds.resize(lines.size(), -1);
-
-		std::vector<size_t>* last = nullptr;
-		for (size_t i = 0; i < passingBranches.size(); i++) {
-			if (!last || passingBranches[i].size() != last->size() || passingBranches[i] != *last) {
-				PassingBranchs pb;
-				pb.passing = passingBranches[i];
-				pb.startLine = i;
-				passingBranchesVec.push_back(pb);
-				last = &passingBranches[i];
-			}
-			passingBranchesInds[i] = passingBranchesVec.size() - 1;
-		}
-
-		auto end1 = std::chrono::high_resolution_clock::now();
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		buildPassingBranches();
+		auto end = std::chrono::high_resolution_clock::now();
 		{
-			double ms = std::chrono::duration_cast<std::chrono::microseconds>(end1 - start1).count()/1000.0;
-			LU_LOGF_(LogUtils::LogLevel_DebugOutput, 
+			double ms = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()/1000.0;
+			DF_LOGF(LogUtils::LogLevel_DebugOutput, 
 				"branch comp took: %f ms; %" CU_PRIuSIZE "=>%" CU_PRIuSIZE " [%" CU_PRIuSIZE " bs,%" CU_PRIuSIZE " lines]", 
 				ms, 
-				passingBranches.size(), passingBranchesVec.size(),
+				lines.size(), passingBranchesVec.size(),
 				branchRoots.size(), lines.size()
 			);
 		}
 	}
 
-#if 1
+	if (!updateLoadProgress(0.8f))
+		return false;
+
 	{
 		auto start = std::chrono::high_resolution_clock::now();
-#if 0
-		for(size_t i = 0; i<passingBranchesVec.size(); i++) {
-			processBranchesRecurse(i);
-		}
-#else
-		for(size_t i = 0; i<branchRoots.size(); i++) {
-			processBranchesRecurse(i);
-		}
-#endif
+		assignBranchDisplayDepths();
 		auto end = std::chrono::high_resolution_clock::now();
 		{
 			double ms = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()/1000.0;
-			LU_LOGF_(LogUtils::LogLevel_DebugOutput, "branch recursion took: %f ms", ms);
+			DF_LOGF(LogUtils::LogLevel_DebugOutput, "branch layout took: %f ms", ms);
 		}
 	}
-#else
-	{	
-		auto start = std::chrono::high_resolution_clock::now();
-		std::vector<size_t> branchsSorted(branchRoots.size());
-		for(size_t i = 0; i<branchsSorted.size(); i++) {
-			branchsSorted[i] = i;
-		}
 
-		std::sort(branchsSorted.begin(), branchsSorted.end(), [&](size_t a, size_t b) {
-			return branchRoots[a].addrDist() < branchRoots[b].addrDist();
-		});
+	for(size_t i = 0; i<branchRoots.size(); i++) {
+		DU_ASSERT(branchRoots[i].displayDepth != (size_t)-1);
+		if (branchRoots[i].displayDepth > maxBranchDisplayDepth && branchRoots[i].displayDepth != (size_t)-3)
+			maxBranchDisplayDepth = branchRoots[i].displayDepth;
+	}
 
-		std::map<addrmcu_t,size_t> destMap;
-		for(size_t i = 0; i< branchsSorted.size(); i++) {
-			BranchRoot& branchRoot = branchRoots[branchsSorted[i]];
+	DF_LOGF(LogUtils::LogLevel_DebugOutput, "branch max Display Depth is %" CU_PRIuSIZE, maxBranchDisplayDepth);
+	return true;
+}
 
-			const size_t from = std::min(branchRoot.startLine, branchRoot.destLine);
-			const size_t to = std::max(branchRoot.startLine, branchRoot.destLine);
+void ABB::DisasmFile::buildPassingBranches() {
+	passingBranchesInds.clear();
+	passingBranchesVec.clear();
+	passingBranchesArena.clear();
+	passingBranchesInds.resize(lines.size(), -1);
+
+	// sweep over the lines, every branch gets added to the passing set at its first line and removed after its last one
+	struct Event {
+		size_t line;
+		uint32_t branchRootInd;
+		bool add;
+	};
+	std::vector<Event> events;
+	events.reserve(branchRoots.size() * 2);
+	for (size_t i = 0; i < branchRoots.size(); i++) {
+		const BranchRoot& branchRoot = branchRoots[i];
+		const size_t from = std::min(branchRoot.startLine, branchRoot.destLine);
+		const size_t to = std::max(branchRoot.startLine, branchRoot.destLine);
 
-			const size_t fromInd = passingBranchesInds[from];
+		events.push_back({ from, (uint32_t)i, true });
+		if (to + 1 < lines.size())
+			events.push_back({ to + 1, (uint32_t)i, false });
+	}
+	std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+		return a.line < b.line;
+	});
+
+	std::unordered_map<uint64_t, uint32_t> arenaLookup; // [hash of list] = start in arena of the first list with that hash
+	std::set<uint32_t> passing; // ordered, so the lists are sorted by branchRootInd
+	std::vector<uint32_t> passingList;
+
+	auto addRun = [&](size_t startLine) {
+		passingList.assign(passing.begin(), passing.end());
+		if (passingBranchesVec.size() > 0) {
+			const PassingBranchs& last = passingBranchesVec.back();
+			if (last.passingLen == passingList.size() && std::equal(passingList.begin(), passingList.end(), passingBranchesArena.begin() + last.passingStart))
+				return; // nothing changed
+		}
 
-			{
-				auto res = destMap.find(branchRoot.dest);
-				if(res != destMap.end()) {
-					branchRoot.displayDepth = res->second;
-					goto skip;
-				}
-			}
+		PassingBranchs pb;
+		pb.startLine = startLine;
+		pb.passingLen = (uint32_t)passingList.size();
 
-			{
+		uint64_t hash = 14695981039346656037ull; // FNV-1a
+		for (uint32_t b : passingList) {
+			hash = (hash ^ b) * 1099511628211ull;
+		}
 
-				BitArray<PassingBranchs::bitArrSize> occupied;
-				size_t toInd = passingBranchesVec.size()-1;
-				for (size_t c = fromInd; c < passingBranchesVec.size(); c++) { // go through line chunks
-					PassingBranchs& pb = passingBranchesVec[c];
+		auto res = arenaLookup.find(hash);
+		if (res != arenaLookup.end() && res->second + passingList.size() <= passingBranchesArena.size() && 
+			std::equal(passingList.begin(), passingList.end(), passingBranchesArena.begin() + res->second)
+		) {
+			pb.passingStart = res->second;
+		}
+		else {
+			pb.passingStart = (uint32_t)passingBranchesArena.size();
+			passingBranchesArena.insert(passingBranchesArena.end(), passingList.begin(), passingList.end());
+			if (res == arenaLookup.end())
+				arenaLookup[hash] = pb.passingStart;
+		}
 
-					if (pb.startLine > to) {
-						toInd = c+1;
-						break;
-					}
+		passingBranchesVec.push_back(pb);
+	};
+
+	size_t sizeBefore = 0; // what the old representation (a vector and a bool[2048] per run) would have needed, just for comparison
+	size_t runStart = 0;
+	size_t e = 0;
+	while (runStart < lines.size()) {
+		for (; e < events.size() && events[e].line == runStart; e++) {
+			if (events[e].add)
+				passing.insert(events[e].branchRootInd);
+			else
+				passing.erase(events[e].branchRootInd);
+		}
 
-					occupied |= pb.occupied;
-				}
+		const size_t prevRuns = passingBranchesVec.size();
+		addRun(runStart);
+		if (passingBranchesVec.size() != prevRuns)
+			sizeBefore += sizeof(std::vector<size_t>) + passing.size()*sizeof(size_t) + sizeof(size_t) + 2048*sizeof(bool);
 
-				size_t minFreePlace = occupied.getLBC();
-				MCU_ASSERT(minFreePlace != (size_t)-1); // check that not every bit is set already
-				branchRoot.displayDepth = minFreePlace;
+		const size_t runEnd = e < events.size() ? events[e].line : lines.size();
+		for (size_t l = runStart; l < runEnd; l++) {
+			passingBranchesInds[l] = (uint32_t)(passingBranchesVec.size() - 1);
+		}
+		runStart = runEnd;
+	}
+	sizeBefore += passingBranchesInds.size()*sizeof(size_t);
+
+	passingBranchesVec.shrink_to_fit();
+	passingBranchesArena.shrink_to_fit();
+	DF_LOGF(LogUtils::LogLevel_DebugOutput, "passing branches memory: %" CU_PRIuSIZE " => %" CU_PRIuSIZE " bytes",
+		sizeBefore,
+		DataUtils::approxSizeOf(passingBranchesVec) + DataUtils::approxSizeOf(passingBranchesInds) + DataUtils::approxSizeOf(passingBranchesArena)
+	);
+}
 
-				destMap[branchRoot.dest] = branchRoot.displayDepth;
-			}
+void ABB::DisasmFile::assignBranchDisplayDepths() {
+	/*
+		Interval coloring via a sweep line: every branch gets the lowest lane that isn't used by 
+		any overlapping branch. Branches to the same destination may share a lane, so they are 
+		merged into one interval (they all contain the destLine, so the union is contiguous).
+		Branches spanning more than maxBranchShowDist lines are hidden (-3).
+	*/
+	struct Group {
+		size_t from;
+		size_t to;
+		size_t depth;
+	};
+	std::vector<Group> groups;
+	std::unordered_map<size_t, size_t> groupOfDest; // [destLine] = ind into groups
+
+	for (auto& branchRoot : branchRoots) {
+		const size_t from = std::min(branchRoot.startLine, branchRoot.destLine);
+		const size_t to = std::max(branchRoot.startLine, branchRoot.destLine);
+		if (to - from > maxBranchShowDist) {
+			branchRoot.displayDepth = -3;
+			continue;
+		}
 
-		skip:
-			for(size_t j = fromInd; j<passingBranchesVec.size(); j++) {
-				PassingBranchs& subPb = passingBranchesVec[j];
-				if (subPb.startLine > to) {
-					break;
-				}
-				subPb.occupied.setBitTo(branchRoot.displayDepth, true);
-			}
+		auto res = groupOfDest.insert({ branchRoot.destLine, groups.size() });
+		if (res.second) {
+			groups.push_back({ from, to, (size_t)-1 });
 		}
+		else {
+			Group& group = groups[res.first->second];
+			group.from = std::min(group.from, from);
+			group.to = std::max(group.to, to);
+		}
+	}
 
-		size_t test[512];
-		std::memset(test, 0, sizeof(test));
-		for(size_t i = 0; i<branchRoots.size(); i++) {
-			MCU_ASSERT(branchRoots[i].displayDepth < 512);
-			test[branchRoots[i].displayDepth] = branchRoots[i].dest;
+	std::vector<size_t> order(groups.size());
+	for (size_t i = 0; i < order.size(); i++) {
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+		return groups[a].from < groups[b].from || (groups[a].from == groups[b].from && groups[a].to > groups[b].to);
+	});
+
+	typedef std::pair<size_t, size_t> ActiveEntry; // {to, depth}
+	std::priority_queue<ActiveEntry, std::vector<ActiveEntry>, std::greater<ActiveEntry>> active;
+	std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>> freeDepths;
+	size_t nextDepth = 0;
+	for (size_t g : order) {
+		Group& group = groups[g];
+		while (!active.empty() && active.top().first < group.from) {
+			freeDepths.push(active.top().second);
+			active.pop();
 		}
 
-		auto end = std::chrono::high_resolution_clock::now();
-		{
-			double ms = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()/1000.0;
-			MCU_LOG_M(LogUtils::LogLevel_DebugOutput, StringUtils::format("branch calc took: %f ms", ms), "Disassembler");
+		if (!freeDepths.empty()) {
+			group.depth = freeDepths.top();
+			freeDepths.pop();
+		}
+		else {
+			group.depth = nextDepth++;
 		}
+		active.push({ group.to, group.depth });
 	}
-#endif
 
-	for(size_t i = 0; i<branchRoots.size(); i++) {
-		DU_ASSERT(branchRoots[i].displayDepth != (size_t)-1);
-		if (branchRoots[i].displayDepth > maxBranchDisplayDepth && branchRoots[i].displayDepth != (size_t)-3)
-			maxBranchDisplayDepth = branchRoots[i].displayDepth;
+	for (auto& branchRoot : branchRoots) {
+		if (branchRoot.displayDepth == (size_t)-3)
+			continue;
+		branchRoot.displayDepth = groups[groupOfDest[branchRoot.destLine]].depth;
 	}
+}
 
-	LU_LOGF_(LogUtils::LogLevel_DebugOutput, "branch max Display Depth is %" CU_PRIuSIZE, maxBranchDisplayDepth);
-}
-#if 0
-const BitArray<256>& ABB::DisasmFile::processBranchesRecurse(size_t ind, size_t depth) {
-	PassingBranchs& pb = passingBranchesVec[ind];
-	for(size_t i = 0; i<pb.passing.size(); i++) {
-		BranchRoot& branch = branchRoots[pb.passing[i]];
-		if(branch.displayDepth == (size_t)-1) {
-			branch.displayDepth = -2;
-			const size_t from = std::min(branch.startLine, branch.destLine);
-			const size_t to = std::max(branch.startLine, branch.destLine);
-			size_t fromInd = passingBranchesInds[from];
-
-			BitArray<256> occupied;
-			size_t toInd = passingBranchesVec.size()-1;
-			for(size_t j = fromInd; j<passingBranchesVec.size(); j++) {
-				PassingBranchs& subPb = passingBranchesVec[j];
-				if (subPb.startLine > to) {
-					toInd = j+1;
-					break;
-				}
-
-				occupied |= processBranchesRecurse(j, depth+1);
-			}
+bool ABB::DisasmFile::processContent(Console* cons) {
+	size_t lineInd = 1;
+	lines.clear();
+	lines.push_back(0);
+	addrs.clear();
+	isLineProgram.clear();
+	labels.clear();
+
+	const char* str = getContent();
+	const size_t len = getContentSize();
+
+	// the line index gets built in chunks, so we can report progress (and cancel) without checking every char.
+	// It is only usable once the whole content is done, a partial view of a big file is loaded separately (see DebuggerBackend::addSrcFile)
+	constexpr size_t chunkSize = 1 << 20;
+	for (size_t chunkStart = 0; chunkStart < len; chunkStart += chunkSize) {
+		if (!updateLoadProgress(0.1f * chunkStart / len))
+			return false;
+
+		const char* chunkEnd = str + std::min(len, chunkStart + chunkSize);
+		const char* ptr = str + chunkStart;
+		while (ptr < chunkEnd && (ptr = (const char*)std::memchr(ptr, '\n', chunkEnd - ptr)) != nullptr) {
+			const size_t i = ptr - str;
+			lines.push_back(i+1);
 
-			size_t minFreePlace = occupied.getLBC();
-			MCU_ASSERT(minFreePlace != (size_t)-1); // check that not every bit is set already
-			branch.displayDepth = minFreePlace;
+			addAddrToList(str + lines[lineInd - 1], str + i, lineInd);
 
-			for(size_t j = fromInd; j<toInd; j++) {
-				PassingBranchs& subPb = passingBranchesVec[j];
-				subPb.occupied.setBitTo(minFreePlace, true);
-			}
+			lineInd++;
+			ptr++;
 		}
 	}
-	return pb.occupied;
+	addAddrToList(str + lines[lineInd - 1], str + len, lineInd);
+	//lineInd++;
+
+	lines.resize(lineInd);
+	addrs.resize(lineInd);
+
+	buildAddrTables();
+
+	instTokenStarts.resize(lines.size() + 1);
+	instTokenStarts[0] = 0;
+	for (size_t i = 0; i < lines.size(); i++) {
+		instTokenStarts[i + 1] = instTokenStarts[i] + (hasInstTokens(i) ? 1 : 0);
+	}
+	instTokens.clear();
+	instTokens.reserve(instTokenStarts.back());
+	tokenizeLines(cons, 0, lines.size(), &instTokens);
+	instTokens.shrink_to_fit();
+
+	if (!processBranches(cons))
+		return false;
+
+	return true;
 }
-#else
-size_t ABB::DisasmFile::processBranchesRecurse(size_t ind, size_t depth) {
-	auto& branchRoot = branchRoots[ind];
-	//if(branchRoot.displayDepth == (size_t)-2) // currently being calculated [we dont need to check that bc the if bolow already does]
-	//	return -2;
-	if(branchRoot.displayDepth != (size_t)-1) // already calculated or currently beeing calculated
-		return branchRoot.displayDepth;
 
-	{
-		bool used[256];
-		branchRoot.displayDepth = -2;
+ABB::DisasmFile::InstTokens ABB::DisasmFile::tokenizeLine(Console* cons, const char* start, const char* end, Console::addrmcu_t addr) {
+	InstTokens tokens;
+	const size_t len = end - start;
+	if (len <= 23 || len > 0xFFFF || start[22] != '\t')
+		return tokens;
+
+	const char* const bytes = start + FileConsts::instBytesStart;
+	tokens.word = StringUtils::hexStrToUIntLen<uint16_t>(bytes, 2) | (StringUtils::hexStrToUIntLen<uint16_t>(bytes + 3, 2) << 8);
+	if (bytes[6] != ' ')
+		tokens.word2 = StringUtils::hexStrToUIntLen<uint16_t>(bytes + 6, 2) | (StringUtils::hexStrToUIntLen<uint16_t>(bytes + 9, 2) << 8);
+
+	const char* const nameStart = start + 23;
+	const char* const paramTab = StringUtils::findCharInStr('\t', nameStart, end);
+	const char* const nameEnd = paramTab ? paramTab : end;
+	tokens.nameEnd = (uint16_t)(nameEnd - start);
+	if (!paramTab)
+		return tokens;
+
+	const char* const comment = StringUtils::findCharInStr(';', paramTab, end);
+	const char* const paramsEnd = comment ? comment : end;
+
+	// params (if there are more than maxParams, the last one gets the rest)
+	for (const char* ptr = paramTab; ptr < paramsEnd && tokens.numParams < InstTokens::maxParams; ) {
+		const char* const comma = StringUtils::findCharInStr(',', ptr, paramsEnd);
+		const char* const paramEnd = (comma && (size_t)tokens.numParams + 1 < InstTokens::maxParams) ? comma + 1 : paramsEnd;
+
+		auto stripped = StringUtils::stripString(ptr, paramEnd);
+		const char* valEnd = stripped.second;
+		if (valEnd > stripped.first && *(valEnd - 1) == ',')
+			valEnd--;
+
+		InstTokens::Param& param = tokens.params[tokens.numParams++];
+		param.start = (uint16_t)(stripped.first - start);
+		param.len = (uint8_t)std::min<size_t>(stripped.second - stripped.first, 0xFF);
+		param.info = cons->disassembler_parseParam(stripped.first, valEnd, nameStart, nameEnd, addr);
+
+		ptr = paramEnd;
+	}
 
-		std::memset(used, 0, sizeof(used));
+	if (comment) {
+		tokens.commentStart = (uint16_t)(comment - start);
+
+		const char* const symbol = StringUtils::findCharInStr('<', comment, end);
+		const char* const symbolEnd = symbol ? StringUtils::findCharInStr('>', symbol, end) : nullptr;
+		if (symbolEnd) {
+			const char* const plus = StringUtils::findCharInStr('+', symbol, symbolEnd);
+			tokens.symbolStart = (uint16_t)(symbol - start);
+			tokens.symbolNameEnd = (uint16_t)((plus ? plus : symbolEnd) - start);
+			tokens.symbolEnd = (uint16_t)(symbolEnd + 1 - start);
+			if (plus)
+				tokens.symbolOff = StringUtils::numStrToUInt<uint32_t>(plus + 1, symbolEnd);
+		}
+	}
 
-		const size_t from = std::min(branchRoot.startLine, branchRoot.destLine);
-		const size_t to = std::max(branchRoot.startLine, branchRoot.destLine);
+	return tokens;
+}
+bool ABB::DisasmFile::hasInstTokens(size_t line) const {
+	return isLineProgram[line] && addrIsActualAddr(addrs[line]);
+}
+void ABB::DisasmFile::tokenizeLines(Console* cons, size_t from, size_t to, std::vector<InstTokens>* out) const {
+	const char* str = getContent();
+	for (size_t i = from; i < to; i++) {
+		if (!hasInstTokens(i))
+			continue;
+
+		const char* lineEnd = str + (i + 1 < lines.size() ? lines[i + 1] : getContentSize());
+		out->push_back(tokenizeLine(cons, str + lines[i], lineEnd, addrs[i]));
+	}
+}
+const ABB::DisasmFile::InstTokens& ABB::DisasmFile::getInstTokens(size_t line) const {
+	static const InstTokens noTokens;
+	if (line + 1 >= instTokenStarts.size() || instTokenStarts[line + 1] == instTokenStarts[line])
+		return noTokens;
 
-#if 1
-		if (to - from > maxBranchShowDist) {
-			branchRoot.displayDepth = -3;
-			return -3;
+	return instTokens[instTokenStarts[line]];
+}
+
+void ABB::DisasmFile::buildAddrTables() {
+	addrToLine.clear();
+	prevActualAddrs.resize(addrs.size());
+	nextActualAddrs.resize(addrs.size());
+
+	// [flash word] = line of the first line with that address
+	for (size_t i = 0; i < addrs.size(); i++) {
+		const Console::addrmcu_t addr = addrs[i];
+		if (!addrIsActualAddr(addr))
+			continue;
+
+		const size_t ind = addr / 2;
+		if (ind >= addrToLine.size())
+			addrToLine.resize(ind + 1, -1);
+		if (addrToLine[ind] == (uint32_t)-1)
+			addrToLine[ind] = (uint32_t)i;
+	}
+	// words that dont appear get the line of the next address after them (the position to insert them at)
+	{
+		uint32_t next = -1;
+		for (size_t i = addrToLine.size(); i > 0; i--) {
+			if (addrToLine[i - 1] == (uint32_t)-1)
+				addrToLine[i - 1] = next;
+			else
+				next = addrToLine[i - 1];
 		}
-#endif
+	}
+	addrToLine.shrink_to_fit();
 
-		size_t fromInd = passingBranchesInds[from];
+	// [line] = nearest actual address before (or at) and after (or at) that line
+	{
+		Console::addrmcu_t prev = 0;
+		for (size_t i = 0; i < addrs.size(); i++) {
+			if (addrIsActualAddr(addrs[i]))
+				prev = addrs[i];
+			prevActualAddrs[i] = prev;
+		}
 
-		for (size_t c = fromInd; c < passingBranchesVec.size(); c++) { // go through line chunks
-			PassingBranchs& pb = passingBranchesVec[c];
+		bool hasNext = false;
+		Console::addrmcu_t next = 0;
+		for (size_t i = addrs.size(); i > 0; i--) {
+			if (addrIsActualAddr(addrs[i - 1])) {
+				next = addrs[i - 1];
+				hasNext = true;
+			}
+			nextActualAddrs[i - 1] = hasNext ? next : prevActualAddrs[i - 1];
+		}
+	}
+}
 
-			if (pb.startLine > to)
-				break;
+size_t ABB::DisasmFile::getLineInstLen(size_t line) const {
+	const char* lineStart = getContent() + lines[line];
+	return *(lineStart+FileConsts::instBytesStart+3+3) != ' ' ? 4 : 2;
+}
 
-			for(size_t i = 0; i< pb.passing.size(); i++) {
-				auto& nextBranchRoot = branchRoots[pb.passing[i]];
-				if (nextBranchRoot.destLine == branchRoot.destLine || nextBranchRoot.displayDepth == (size_t)-2) {
-					continue;
-				}
+std::string ABB::DisasmFile::genInstLine(Console* cons, Console::addrmcu_t addr, uint16_t word, uint16_t word2, size_t len) {
+	char buf[64];
+	if (len == 4) {
+		std::snprintf(buf, sizeof(buf), "%8x:\t%02x %02x %02x %02x \t", addr, word & 0xFF, word >> 8, word2 & 0xFF, word2 >> 8);
+	}
+	else {
+		std::snprintf(buf, sizeof(buf), "%8x:\t%02x %02x       \t", addr, word & 0xFF, word >> 8);
+	}
+	return buf + cons->disassembler_disassembleRaw(word, word2) + "\n";
+}
 
-				size_t d;
-				if(nextBranchRoot.displayDepth == (size_t)-1){
-					d = processBranchesRecurse(pb.passing[i], depth+1);
-				}else{
-					d = nextBranchRoot.displayDepth;
-				}
+// replaces [start, oldEnd) of vec with [newBegin, newEnd), the elements after it only get moved if the length changes
+template<typename T, typename It>
+static void replaceRange(std::vector<T>& vec, size_t start, size_t oldEnd, It newBegin, It newEnd) {
+	const size_t oldLen = oldEnd - start;
+	const size_t newLen = (size_t)std::distance(newBegin, newEnd);
+	const size_t common = std::min(oldLen, newLen);
+	std::copy(newBegin, newBegin + common, vec.begin() + start);
+	if (newLen > oldLen)
+		vec.insert(vec.begin() + oldEnd, newBegin + common, newEnd);
+	else if (newLen < oldLen)
+		vec.erase(vec.begin() + start + newLen, vec.begin() + oldEnd);
+}
+// changes the length of the range ending at oldEnd by delta, its content has to be set again afterwards
+template<typename T>
+static void resizeRange(std::vector<T>& vec, size_t oldEnd, ptrdiff_t delta) {
+	if (delta > 0)
+		vec.insert(vec.begin() + oldEnd, (size_t)delta, T());
+	else if (delta < 0)
+		vec.erase(vec.begin() + (oldEnd - (size_t)-delta), vec.begin() + oldEnd);
+}
 
-				if(d == (size_t)-2) // currently being calculated, so we skip it
-					continue;
-				if (d == (size_t)-3) // ignored branch
-					continue;
+bool ABB::DisasmFile::redisassembleRange(Console* cons, Console::addrmcu_t from, Console::addrmcu_t to) {
+	if (isEmpty())
+		return false;
 
-				DU_ASSERT(d < sizeof(used));
+	// every disassembled region in the range gets updated on its own, data between them stays as it is
+	bool updated = false;
+	size_t next = from & ~1;
+	while (next != (size_t)-1 && next <= to)
+		next = redisassembleRegion(cons, (Console::addrmcu_t)next, to, &updated);
+	return updated;
+}
 
-				used[d] = true;
+size_t ABB::DisasmFile::redisassembleRegion(Console* cons, Console::addrmcu_t from, Console::addrmcu_t to, bool* updated) {
+	const uint8_t* flash = cons->flash_getData();
+	const size_t flashSize = cons->flash_size();
+	auto getWord = [&](size_t addr) -> uint16_t {
+		return addr + 1 < flashSize ? (flash[addr] | (flash[addr + 1] << 8)) : 0;
+	};
+	// returns the nearest line before line that has an address (-1 if there is none)
+	auto prevAddrLine = [&](size_t line) -> size_t {
+		while (line > 0) {
+			line--;
+			if (addrIsActualAddr(addrs[line]))
+				return line;
+		}
+		return -1;
+	};
+	// returns true if the old instruction line before line covers addr (so addr isn't the start of an instruction)
+	auto isInsideOldInst = [&](size_t line, size_t addr) {
+		const size_t prev = prevAddrLine(line);
+		return prev != (size_t)-1 && isLineProgram[prev] && addrs[prev] < addr && addrs[prev] + getLineInstLen(prev) > addr;
+	};
+	// returns true if addr is the start of data or inside of it (line is the first line at or after addr)
+	auto isData = [&](size_t line, size_t addr) {
+		if (line < lines.size() && addrs[line] == addr)
+			return !isLineProgram[line];
+		const size_t prev = prevAddrLine(line);
+		return prev != (size_t)-1 && !isLineProgram[prev];
+	};
+
+	// find the first instruction the edit touches, data before it gets skipped
+	size_t startLine = getLineIndFromAddr(from);
+	if (startLine == (size_t)-1)
+		return -1;
+	if (addrs[startLine] != from && isInsideOldInst(startLine, from))
+		startLine = prevAddrLine(startLine);
+	while (startLine < lines.size() && !(isLineProgram[startLine] && addrIsActualAddr(addrs[startLine])))
+		startLine++;
+	if (startLine >= lines.size() || addrs[startLine] > to)
+		return -1; // the rest of the edit was in data or in something that wasn't disassembled
+
+	// decode until we are past the edit and back in sync with the old instruction boundaries (or hit data)
+	std::vector<std::pair<Console::addrmcu_t, std::string>> decoded;
+	size_t endLine;
+	size_t next = -1; // where the next region starts if this one was ended by data
+	{
+		size_t addr = addrs[startLine];
+		while (true) {
+			const uint16_t word = getWord(addr);
+			const uint16_t word2 = getWord(addr + 2);
+			const size_t len = cons->disassembler_getInstLen(word) * 2;
+			decoded.push_back({ (Console::addrmcu_t)addr, genInstLine(cons, (Console::addrmcu_t)addr, word, word2, len) });
+			addr += len;
+
+			if (addr >= flashSize) {
+				endLine = lines.size();
+				break;
+			}
+			size_t line = getLineIndFromAddr((Console::addrmcu_t)addr);
+			if (line == (size_t)-1)
+				line = lines.size();
+			if (isData(line, addr)) {
+				endLine = line < lines.size() && addrs[line] == addr ? line : prevAddrLine(line);
+				next = addr;
+				break;
+			}
+			if (addr > to) {
+				endLine = line;
+				if (endLine == lines.size() || addrs[endLine] == addr || !isInsideOldInst(endLine, addr))
+					break;
 			}
 		}
+		// non instruction lines (labels, source...) right before the next instruction belong to it
+		while (endLine > startLine + 1 && !addrIsActualAddr(addrs[endLine - 1]))
+			endLine--;
+	}
 
-		size_t min = -1;
-		for(size_t i = 0; i<sizeof(used); i++) {
-			if(!used[i]) {
-				min = i;
-				break;
+	// build the replacement text, non instruction lines are kept as they are
+	const bool atEnd = endLine == lines.size();
+	std::string newText;
+	std::vector<size_t> newLines; // relative to the start of the window
+	std::vector<Console::addrmcu_t> newAddrs;
+	std::vector<bool> newIsLineProgram;
+	std::vector<size_t> oldToNew(endLine - startLine, -1);
+	{
+		size_t d = 0;
+		auto emitDecoded = [&]() {
+			newLines.push_back(newText.size());
+			newAddrs.push_back(decoded[d].first);
+			newIsLineProgram.push_back(true);
+			newText += decoded[d].second;
+			d++;
+		};
+
+		for (size_t l = startLine; l < endLine; l++) {
+			const Console::addrmcu_t addr = addrs[l];
+			if (!addrIsActualAddr(addr)) {
+				const size_t lineStart = lines[l];
+				const size_t lineEnd = l + 1 < lines.size() ? lines[l + 1] : ownedContent.size();
+				if (lineStart == lineEnd)
+					continue; // empty last line, gets readded below
+
+				oldToNew[l - startLine] = newLines.size();
+				newLines.push_back(newText.size());
+				newAddrs.push_back(addr);
+				newIsLineProgram.push_back(isLineProgram[l]);
+				newText.append(ownedContent, lineStart, lineEnd - lineStart);
+				if (newText.back() != '\n')
+					newText += '\n';
+				continue;
+			}
+
+			while (d < decoded.size() && decoded[d].first < addr)
+				emitDecoded();
+			if (d < decoded.size() && decoded[d].first == addr)
+				emitDecoded();
+			// otherwise this instruction got swallowed by the one before it
+		}
+		while (d < decoded.size())
+			emitDecoded();
+
+		if (atEnd) {
+			if (ownedContent.size() > 0 && ownedContent.back() == '\n') {
+				newLines.push_back(newText.size()); // the empty line after the last newline
+				newAddrs.push_back(Addrs_notAnAddr);
+				newIsLineProgram.push_back(false);
 			}
+			else {
+				newText.pop_back();
+			}
+		}
+	}
+
+	// splice everything in, the lines after the window only get moved
+	const size_t oldStart = lines[startLine];
+	const size_t oldEnd = atEnd ? ownedContent.size() : lines[endLine];
+	const ptrdiff_t byteDelta = (ptrdiff_t)newText.size() - (ptrdiff_t)(oldEnd - oldStart);
+	const ptrdiff_t lineDelta = (ptrdiff_t)newLines.size() - (ptrdiff_t)(endLine - startLine);
+	const size_t newEndLine = startLine + newLines.size();
+
+	ownedContent.replace(oldStart, oldEnd - oldStart, newText);
+
+	for (auto& l : newLines)
+		l += oldStart;
+	replaceRange(lines, startLine, endLine, newLines.begin(), newLines.end());
+	if (byteDelta != 0) {
+		for (size_t l = newEndLine; l < lines.size(); l++)
+			lines[l] += byteDelta;
+	}
+
+	replaceRange(addrs, startLine, endLine, newAddrs.begin(), newAddrs.end());
+	replaceRange(isLineProgram, startLine, endLine, newIsLineProgram.begin(), newIsLineProgram.end());
+	{
+		const size_t oldTokensStart = instTokenStarts[startLine];
+		const size_t oldTokensEnd = instTokenStarts[endLine];
+		std::vector<InstTokens> newTokens;
+		tokenizeLines(cons, startLine, newEndLine, &newTokens);
+		const ptrdiff_t tokensDelta = (ptrdiff_t)newTokens.size() - (ptrdiff_t)(oldTokensEnd - oldTokensStart);
+
+		std::vector<uint32_t> newStarts(newLines.size());
+		uint32_t tokenInd = (uint32_t)oldTokensStart;
+		for (size_t l = 0; l < newLines.size(); l++) {
+			tokenInd += hasInstTokens(startLine + l) ? 1 : 0;
+			newStarts[l] = tokenInd; // entry of the line after l
+		}
+		replaceRange(instTokenStarts, startLine + 1, endLine + 1, newStarts.begin(), newStarts.end());
+		if (tokensDelta != 0) {
+			for (size_t l = newEndLine + 1; l < instTokenStarts.size(); l++)
+				instTokenStarts[l] += (uint32_t)tokensDelta;
 		}
 
-		branchRoot.displayDepth = min;
+		replaceRange(instTokens, oldTokensStart, oldTokensEnd, newTokens.begin(), newTokens.end());
+	}
 
-		return branchRoot.displayDepth;
+	for (auto& label : labels) {
+		if (label.second >= endLine)
+			label.second += lineDelta;
+		else if (label.second >= startLine)
+			label.second = startLine + oldToNew[label.second - startLine];
 	}
-}
-#endif
 
-void ABB::DisasmFile::processContent(Console* cons) {
-	size_t lineInd = 1;
-	lines.clear();
-	lines.push_back(0);
-	addrs.clear();
-	isLineProgram.clear();
+	updateAddrTablesAfterSplice(startLine, endLine, newEndLine);
+	updateBranchesAfterSplice(cons, startLine, endLine, newEndLine);
 
-	const char* str = content.c_str();
-	size_t i = 0;
-	for(; i < content.size(); i++) {
-		if(str[i] == '\n'){
-			lines.push_back(i+1);
+	*updated = true;
+	DF_LOGF(LogUtils::LogLevel_DebugOutput, "redisassembled lines %" CU_PRIuSIZE "-%" CU_PRIuSIZE " (%" CU_PRIuSIZE " instructions)", startLine, newEndLine, decoded.size());
+	return next;
+}
 
-			addAddrToList(str + lines[lineInd - 1], str + i, lineInd);
+void ABB::DisasmFile::updateAddrTablesAfterSplice(size_t startLine, size_t oldEndLine, size_t newEndLine) {
+	const ptrdiff_t lineDelta = (ptrdiff_t)newEndLine - (ptrdiff_t)oldEndLine;
+	resizeRange(prevActualAddrs, oldEndLine, lineDelta);
+	resizeRange(nextActualAddrs, oldEndLine, lineDelta);
 
-			lineInd++;
+	// only whats between the nearest addresses around the window can change, everything after that just moves
+	size_t prevLine = -1; // last line with an address before the window
+	for (size_t l = startLine; l > 0; l--) {
+		if (addrIsActualAddr(addrs[l - 1])) {
+			prevLine = l - 1;
+			break;
+		}
+	}
+	size_t nextLine = -1; // first line with an address after the window
+	for (size_t l = newEndLine; l < addrs.size(); l++) {
+		if (addrIsActualAddr(addrs[l])) {
+			nextLine = l;
+			break;
 		}
 	}
-	addAddrToList(str + lines[lineInd - 1], str + content.size(), lineInd);
-	//lineInd++;
 
-	lines.resize(lineInd);
-	addrs.resize(lineInd);
+	const size_t wordFrom = prevLine != (size_t)-1 ? addrs[prevLine] / 2 + 1 : 0;
+	size_t wordTo; // exclusive
+	if (nextLine != (size_t)-1) {
+		wordTo = addrs[nextLine] / 2 + 1;
+		if (lineDelta != 0) {
+			for (size_t w = wordTo; w < addrToLine.size(); w++) {
+				if (addrToLine[w] != (uint32_t)-1)
+					addrToLine[w] += (uint32_t)lineDelta;
+			}
+		}
+	}
+	else { // there is nothing after the window, so the table ends with it
+		wordTo = wordFrom;
+		for (size_t l = startLine; l < newEndLine; l++) {
+			if (addrIsActualAddr(addrs[l]))
+				wordTo = std::max(wordTo, (size_t)addrs[l] / 2 + 1);
+		}
+		addrToLine.resize(wordTo, -1);
+	}
 
-	processBranches(cons);
+	for (size_t w = wordFrom; w < wordTo; w++) {
+		addrToLine[w] = -1;
+	}
+	for (size_t l = startLine; l < (nextLine != (size_t)-1 ? nextLine + 1 : newEndLine); l++) {
+		if (!addrIsActualAddr(addrs[l]))
+			continue;
 
-	for (size_t i = 0; i < lines.size(); i++) {
-		Console::addrmcu_t addr = addrs[i];
-		if (addr != Addrs_notAnAddr && addr != Addrs_symbolLabel) {
+		const size_t w = addrs[l] / 2;
+		if (w >= wordFrom && w < wordTo && addrToLine[w] == (uint32_t)-1)
+			addrToLine[w] = (uint32_t)l;
+	}
+	{
+		uint32_t next = wordTo < addrToLine.size() ? addrToLine[wordTo] : -1;
+		for (size_t w = wordTo; w > wordFrom; w--) {
+			if (addrToLine[w - 1] == (uint32_t)-1)
+				addrToLine[w - 1] = next;
+			else
+				next = addrToLine[w - 1];
+		}
+	}
 
+	const size_t lineFrom = prevLine != (size_t)-1 ? prevLine : 0;
+	const size_t lineTo = nextLine != (size_t)-1 ? nextLine + 1 : addrs.size();
+	{
+		Console::addrmcu_t prev = lineFrom > 0 ? prevActualAddrs[lineFrom - 1] : 0;
+		for (size_t l = lineFrom; l < lineTo; l++) {
+			if (addrIsActualAddr(addrs[l]))
+				prev = addrs[l];
+			prevActualAddrs[l] = prev;
+		}
+
+		bool hasNext = false;
+		Console::addrmcu_t next = 0;
+		for (size_t l = lineTo; l > lineFrom; l--) {
+			if (addrIsActualAddr(addrs[l - 1])) {
+				next = addrs[l - 1];
+				hasNext = true;
+			}
+			nextActualAddrs[l - 1] = hasNext ? next : prevActualAddrs[l - 1];
 		}
 	}
 }
 
-bool ABB::DisasmFile::addrIsActualAddr(Console::addrmcu_t addr) {
-	return addr != Addrs_notAnAddr && addr != Addrs_symbolLabel;
-}
-bool ABB::DisasmFile::addrIsNotProgram(Console::addrmcu_t addr) {
-	return addr == Addrs_notAnAddr;
-}
-bool ABB::DisasmFile::addrIsSymbol(Console::addrmcu_t addr) {
-	return addr == Addrs_symbolLabel;
-}
+void ABB::DisasmFile::updateBranchesAfterSplice(Console* cons, size_t startLine, size_t oldEndLine, size_t newEndLine) {
+	const ptrdiff_t lineDelta = (ptrdiff_t)newEndLine - (ptrdiff_t)oldEndLine;
+	const size_t oldNumLines = passingBranchesInds.size();
+	auto isHidden = [](const BranchRoot& b) {
+		return std::max(b.startLine, b.destLine) - std::min(b.startLine, b.destLine) > maxBranchShowDist;
+	};
+	// maps a line from before the splice to after it, lines inside of the window get mapped to its start
+	auto mapLine = [&](size_t line) -> size_t {
+		return line < startLine ? line : (line >= oldEndLine ? line + lineDelta : startLine);
+	};
+
+	/*
+		Only branches that pass the window can change (besides jumps whose destination appears or disappears),
+		so the passing lists only get rebuilt for the lines these branches cover (dirtyFrom/To, after the splice)
+		and everything after that gets moved
+	*/
+	size_t dirtyFrom = startLine;
+	size_t dirtyTo = newEndLine - 1;
+	auto markDirty = [&](size_t a, size_t b) {
+		dirtyFrom = std::min(dirtyFrom, std::min(a, b));
+		dirtyTo = std::max(dirtyTo, std::max(a, b));
+	};
+
+	std::vector<uint32_t> passingWindow; // old branchRootInds
+	for (size_t c = passingBranchesInds[startLine]; c < passingBranchesVec.size() && passingBranchesVec[c].startLine < oldEndLine; c++) {
+		for (uint32_t b : getPassingBranches(passingBranchesVec[c]))
+			passingWindow.push_back(b);
+	}
+	std::sort(passingWindow.begin(), passingWindow.end());
+	passingWindow.erase(std::unique(passingWindow.begin(), passingWindow.end()), passingWindow.end());
+
+	auto byStartLine = [](const BranchRoot& b, size_t line) {
+		return b.startLine < line;
+	};
+	const size_t windowRootsFrom = std::lower_bound(branchRoots.begin(), branchRoots.end(), startLine, byStartLine) - branchRoots.begin();
+	const size_t windowRootsTo = std::lower_bound(branchRoots.begin(), branchRoots.end(), oldEndLine, byStartLine) - branchRoots.begin();
+	for (size_t i = windowRootsFrom; i < windowRootsTo; i++) {
+		markDirty(mapLine(branchRoots[i].startLine), mapLine(branchRoots[i].destLine));
+	}
 
-size_t ABB::DisasmFile::getLineIndFromAddr(Console::addrmcu_t Addr) const{
-	if(isEmpty())
-		return -1;
+	// branches from outside into the window need their destination again
+	std::vector<uint32_t> removed; // old inds of branches whose destination got swallowed by an edited instruction
+	std::vector<std::pair<uint32_t, size_t>> destMoved; // {old ind, new destLine}
+	for (uint32_t b : passingWindow) {
+		const BranchRoot& root = branchRoots[b];
+		if ((b >= windowRootsFrom && b < windowRootsTo) || root.destLine < startLine || root.destLine >= oldEndLine)
+			continue;
+
+		markDirty(mapLine(root.startLine), mapLine(root.destLine));
+		const size_t destLine = getLineIndFromAddr(root.dest);
+		if (destLine == (size_t)-1 || addrs[destLine] != root.dest) {
+			removed.push_back(b);
+		}
+		else {
+			destMoved.push_back({ b, destLine });
+			markDirty(mapLine(root.startLine), destLine);
+		}
+	}
 
-	size_t from = 0;
-	size_t to = lines.size()-1;
-	while (to > 0 && (addrs[to] == Addrs_notAnAddr || addrs[to] == Addrs_symbolLabel))
-		to--;
-	if (addrs[to] < Addr || to == (decltype(to))-1)
-		return -1;
+	// the window gets decoded again and jumps that didnt have a destination might have one now
+	std::vector<BranchRoot> added; // new roots, after the splice
+	bool addedOutside = false;
+	{
+		std::vector<std::pair<size_t, Console::addrmcu_t>> unresolved;
+		auto check = [&](size_t line, Console::addrmcu_t dest) {
+			const size_t destLine = getLineIndFromAddr(dest);
+			if (destLine == (size_t)-1 || addrs[destLine] != dest) {
+				unresolved.push_back({ line, dest });
+				return;
+			}
+			BranchRoot b;
+			if (getBranchRootOfLine(cons, line, &b)) {
+				added.push_back(b);
+				addedOutside = true;
+				markDirty(b.startLine, b.destLine);
+			}
+		};
+
+		size_t u = 0;
+		for (; u < unresolvedBranches.size() && unresolvedBranches[u].first < startLine; u++)
+			check(unresolvedBranches[u].first, unresolvedBranches[u].second);
+		for (; u < unresolvedBranches.size() && unresolvedBranches[u].first < oldEndLine; u++)
+			;
+		for (size_t l = startLine; l < newEndLine; l++) {
+			BranchRoot b;
+			Console::addrmcu_t missingDest = Addrs_notAnAddr;
+			if (getBranchRootOfLine(cons, l, &b, &missingDest)) {
+				added.push_back(b);
+				markDirty(b.startLine, b.destLine);
+			}
+			else if (missingDest != Addrs_notAnAddr) {
+				unresolved.push_back({ l, missingDest });
+			}
+		}
+		for (; u < unresolvedBranches.size(); u++)
+			check(unresolvedBranches[u].first + lineDelta, unresolvedBranches[u].second);
+		for (uint32_t b : removed)
+			unresolved.push_back({ mapLine(branchRoots[b].startLine), branchRoots[b].dest });
 
-	while(from != to){
-		const size_t mid_orig = from + ((to-from)/2);
-		size_t mid = mid_orig;
+		std::sort(unresolved.begin(), unresolved.end());
+		unresolvedBranches = std::move(unresolved);
+	}
+	std::sort(added.begin(), added.end(), [](const BranchRoot& a, const BranchRoot& b) {
+		return a.startLine < b.startLine;
+	});
+	std::sort(removed.begin(), removed.end());
+
+	// move the branches outside of the window
+	if (lineDelta != 0) {
+		for (size_t i = windowRootsTo; i < branchRoots.size(); i++) {
+			branchRoots[i].startLine += lineDelta;
+			if (branchRoots[i].destLine >= oldEndLine)
+				branchRoots[i].destLine += lineDelta;
+		}
+		for (uint32_t b : passingWindow) {
+			if (b < windowRootsFrom && branchRoots[b].destLine >= oldEndLine)
+				branchRoots[b].destLine += lineDelta;
+		}
+	}
+	for (auto& moved : destMoved) {
+		branchRoots[moved.first].destLine = moved.second;
+	}
 
-		uint16_t lineAddr = addrs[mid];
-		//while((lineAddr = addrs[mid]) == Addrs_notAnAddr || lineAddr == Addrs_symbolLabel)
-		//	mid++;
+	// branches that need a (new) lane, old inds for now
+	std::vector<uint32_t> affected;
+	{
+		size_t m = 0;
+		size_t r = 0;
+		for (uint32_t b : passingWindow) {
+			if (b >= windowRootsFrom && b < windowRootsTo)
+				continue;
+			while (r < removed.size() && removed[r] < b)
+				r++;
+			if (r < removed.size() && removed[r] == b)
+				continue;
+
+			while (m < destMoved.size() && destMoved[m].first < b)
+				m++;
+			const bool wasHidden = branchRoots[b].displayDepth == (size_t)-3;
+			if ((m < destMoved.size() && destMoved[m].first == b) || isHidden(branchRoots[b]) != wasHidden)
+				affected.push_back(b);
+		}
+	}
+
+	// splice in the new branches, if their number didnt change the inds stay the same
+	const bool sameInds = removed.size() == 0 && !addedOutside && added.size() == windowRootsTo - windowRootsFrom;
+	size_t firstChanged = windowRootsFrom; // first ind that might be a different branch now
+	resizeRange(branchRootInds, oldEndLine, lineDelta);
+	for (size_t l = startLine; l < newEndLine; l++) {
+		branchRootInds[l] = -1;
+	}
+	if (sameInds) {
+		for (size_t i = 0; i < added.size(); i++) {
+			branchRoots[windowRootsFrom + i] = added[i];
+			affected.push_back((uint32_t)(windowRootsFrom + i));
+		}
+	}
+	else {
+		std::vector<uint32_t> oldToNew(branchRoots.size(), -1);
+		std::vector<BranchRoot> newRoots;
+		newRoots.reserve(branchRoots.size() + added.size());
+		std::vector<uint32_t> addedInds;
+		size_t a = 0;
+		size_t r = 0;
+		for (size_t i = 0; i <= branchRoots.size(); i++) {
+			const size_t line = i < branchRoots.size() ? branchRoots[i].startLine : (size_t)-1;
+			const bool inWindow = i >= windowRootsFrom && i < windowRootsTo; // still has its old line
+			while (a < added.size() && (inWindow || added[a].startLine < line)) {
+				if (inWindow && added[a].startLine >= newEndLine)
+					break;
+				addedInds.push_back((uint32_t)newRoots.size());
+				newRoots.push_back(added[a++]);
+			}
+			if (i == branchRoots.size())
+				break;
+			if (inWindow)
+				continue;
+			if (r < removed.size() && removed[r] == i) {
+				branchRootInds[branchRoots[i].startLine] = -1;
+				r++;
+				continue;
+			}
+			oldToNew[i] = (uint32_t)newRoots.size();
+			newRoots.push_back(branchRoots[i]);
+		}
+		branchRoots = std::move(newRoots);
+
+		for (auto& b : affected)
+			b = oldToNew[b];
+		affected.insert(affected.end(), addedInds.begin(), addedInds.end());
+		if (removed.size() > 0)
+			firstChanged = std::min<size_t>(firstChanged, removed[0]);
+		if (addedInds.size() > 0)
+			firstChanged = std::min<size_t>(firstChanged, addedInds[0]);
+
+		// lists of lines that arent dirty only contain branches that are still there
+		for (auto& b : passingBranchesArena) {
+			b = b < oldToNew.size() ? oldToNew[b] : -1;
+		}
+	}
+	for (size_t i = firstChanged; i < branchRoots.size(); i++) {
+		branchRootInds[branchRoots[i].startLine] = i;
+	}
 
-		while (!addrIsActualAddr(lineAddr)) {
-			if (mid >= to) {
-				return -1;
+	// rebuild the passing lists of the dirty lines
+	const size_t oldDirtyTo = dirtyTo >= newEndLine ? dirtyTo - lineDelta : oldEndLine - 1;
+	std::vector<PassingBranchs> newRuns;
+	std::vector<uint32_t> dirtyRunInds(dirtyTo - dirtyFrom + 1); // [line - dirtyFrom] = ind into newRuns
+	{
+		std::vector<uint32_t> candidates;
+		for (size_t c = passingBranchesInds[dirtyFrom]; c < passingBranchesVec.size() && passingBranchesVec[c].startLine <= oldDirtyTo; c++) {
+			for (uint32_t b : getPassingBranches(passingBranchesVec[c])) {
+				if (b != (uint32_t)-1)
+					candidates.push_back(b);
 			}
+		}
+		for (size_t i = windowRootsFrom; i < branchRoots.size() && branchRoots[i].startLine < newEndLine; i++)
+			candidates.push_back((uint32_t)i);
+		for (uint32_t b : affected)
+			candidates.push_back(b);
+		std::sort(candidates.begin(), candidates.end());
+		candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+		struct Event {
+			size_t line;
+			uint32_t branchRootInd;
+			bool add;
+		};
+		std::vector<Event> events;
+		for (uint32_t b : candidates) {
+			const BranchRoot& branchRoot = branchRoots[b];
+			const size_t from = std::max(std::min(branchRoot.startLine, branchRoot.destLine), dirtyFrom);
+			const size_t to = std::min(std::max(branchRoot.startLine, branchRoot.destLine), dirtyTo);
+			if (from > to)
+				continue;
 
-			if (mid <= mid_orig) {
-				mid = mid_orig + (mid_orig - mid) + 1;
+			events.push_back({ from, b, true });
+			if (to < dirtyTo)
+				events.push_back({ to + 1, b, false });
+		}
+		std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+			return a.line < b.line;
+		});
+
+		std::set<uint32_t> passing;
+		std::vector<uint32_t> passingList;
+		size_t runStart = dirtyFrom;
+		size_t e = 0;
+		while (runStart <= dirtyTo) {
+			for (; e < events.size() && events[e].line == runStart; e++) {
+				if (events[e].add)
+					passing.insert(events[e].branchRootInd);
+				else
+					passing.erase(events[e].branchRootInd);
 			}
-			else {
-				if (mid - mid_orig <= mid_orig) {
-					mid = mid_orig - (mid - mid_orig);
+
+			passingList.assign(passing.begin(), passing.end());
+			if (newRuns.size() == 0 || newRuns.back().passingLen != passingList.size() ||
+				!std::equal(passingList.begin(), passingList.end(), passingBranchesArena.begin() + newRuns.back().passingStart)
+			) {
+				PassingBranchs pb;
+				pb.startLine = runStart;
+				pb.passingLen = (uint32_t)passingList.size();
+
+				// reuse the list that was there before if it didnt change, so the arena doesnt grow with every edit
+				// (lists that arent used anymore stay in it until the file gets loaded again)
+				const size_t oldLine = runStart < startLine ? runStart : (runStart >= newEndLine ? runStart - lineDelta : (size_t)-1);
+				const PassingBranchs* old = oldLine != (size_t)-1 ? &passingBranchesVec[passingBranchesInds[oldLine]] : nullptr;
+				if (old && old->passingLen == passingList.size() && std::equal(passingList.begin(), passingList.end(), passingBranchesArena.begin() + old->passingStart)) {
+					pb.passingStart = old->passingStart;
 				}
 				else {
-					mid++;
+					pb.passingStart = (uint32_t)passingBranchesArena.size();
+					passingBranchesArena.insert(passingBranchesArena.end(), passingList.begin(), passingList.end());
 				}
+				newRuns.push_back(pb);
 			}
-			// + (cnt/2>mid_orig ? (cnt-mid_orig/2) : ((cnt % 2) ? -(ptrdiff_t)cnt / 2 : cnt / 2));
-			lineAddr = addrs[mid];
+
+			const size_t runEnd = e < events.size() ? events[e].line : dirtyTo + 1;
+			for (size_t l = runStart; l < runEnd; l++) {
+				dirtyRunInds[l - dirtyFrom] = (uint32_t)(newRuns.size() - 1);
+			}
+			runStart = runEnd;
 		}
+	}
 
-		if(lineAddr == Addr){
-			return mid;
+	{
+		const size_t runFirst = passingBranchesInds[dirtyFrom];
+		const size_t runLast = passingBranchesInds[oldDirtyTo];
+		const size_t replaceFrom = passingBranchesVec[runFirst].startLine < dirtyFrom ? runFirst + 1 : runFirst; // the run before might still cover lines before the dirty ones
+		if (oldDirtyTo + 1 < oldNumLines && passingBranchesInds[oldDirtyTo + 1] == runLast) { // the last run continues after the dirty lines
+			PassingBranchs tail = passingBranchesVec[runLast];
+			tail.startLine = dirtyTo + 1;
+			newRuns.push_back(tail);
 		}
-		else {
-			if (lineAddr < Addr) {
-				if (mid == from) {
-					if (addrs[to] == Addr) {
-						return to;
-					}
-					else {
-						return -1;
-					}
-				}
+		const ptrdiff_t runDelta = (ptrdiff_t)newRuns.size() - (ptrdiff_t)(runLast + 1 - replaceFrom);
 
-				from = mid;
-			}else{
-				if (mid == to) {
-					if (mid_orig == to)
-						return from;
-					else
-						to = mid_orig;
-				}
-				else {
-					to = mid;
+		if (lineDelta != 0) {
+			for (size_t c = runLast + 1; c < passingBranchesVec.size(); c++)
+				passingBranchesVec[c].startLine += lineDelta;
+		}
+		replaceRange(passingBranchesVec, replaceFrom, runLast + 1, newRuns.begin(), newRuns.end());
+
+		resizeRange(passingBranchesInds, oldEndLine, lineDelta);
+		for (size_t l = dirtyFrom; l <= dirtyTo; l++) {
+			passingBranchesInds[l] = (uint32_t)(replaceFrom + dirtyRunInds[l - dirtyFrom]);
+		}
+		if (runDelta != 0) {
+			for (size_t l = dirtyTo + 1; l < passingBranchesInds.size(); l++)
+				passingBranchesInds[l] += (uint32_t)runDelta;
+		}
+	}
+
+	// only the affected branches get a lane, everything else stays where it was
+	for (uint32_t a : affected) {
+		branchRoots[a].displayDepth = -1;
+	}
+	std::vector<bool> used;
+	for (uint32_t a : affected) {
+		BranchRoot& branchRoot = branchRoots[a];
+		if (isHidden(branchRoot)) {
+			branchRoot.displayDepth = -3;
+			continue;
+		}
+
+		const size_t from = std::min(branchRoot.startLine, branchRoot.destLine);
+		const size_t to = std::max(branchRoot.startLine, branchRoot.destLine);
+
+		used.assign(used.size(), false);
+		size_t sameDestDepth = -1; // lane of an other branch with the same destination
+		for (size_t c = passingBranchesInds[from]; c < passingBranchesVec.size() && passingBranchesVec[c].startLine <= to; c++) {
+			for (uint32_t other : getPassingBranches(passingBranchesVec[c])) {
+				const BranchRoot& o = branchRoots[other];
+				if (o.displayDepth == (size_t)-1 || o.displayDepth == (size_t)-3)
+					continue;
+				if (o.destLine == branchRoot.destLine) {
+					sameDestDepth = o.displayDepth;
+					continue;
 				}
+				if (o.displayDepth >= used.size())
+					used.resize(o.displayDepth + 1, false);
+				used[o.displayDepth] = true;
 			}
 		}
+
+		if (sameDestDepth != (size_t)-1 && (sameDestDepth >= used.size() || !used[sameDestDepth])) {
+			branchRoot.displayDepth = sameDestDepth;
+		}
+		else {
+			size_t depth = 0;
+			while (depth < used.size() && used[depth])
+				depth++;
+			branchRoot.displayDepth = depth;
+		}
+		maxBranchDisplayDepth = std::max(maxBranchDisplayDepth, branchRoot.displayDepth); // only grows, a lane that isnt used anymore just stays empty
 	}
-	return from;
+}
+
+bool ABB::DisasmFile::addrIsActualAddr(Console::addrmcu_t addr) {
+	return addr != Addrs_notAnAddr && addr != Addrs_symbolLabel;
+}
+bool ABB::DisasmFile::addrIsNotProgram(Console::addrmcu_t addr) {
+	return addr == Addrs_notAnAddr;
+}
+bool ABB::DisasmFile::addrIsSymbol(Console::addrmcu_t addr) {
+	return addr == Addrs_symbolLabel;
+}
+
+size_t ABB::DisasmFile::getLineIndFromAddr(Console::addrmcu_t Addr) const{
+	const size_t ind = ((size_t)Addr + 1) / 2; // odd addresses arent in the table, so we round them up to the next possible insert position
+	if(ind >= addrToLine.size() || addrToLine[ind] == (uint32_t)-1)
+		return -1;
+
+	return addrToLine[ind];
 }
 bool ABB::DisasmFile::isEmpty() const {
-	return content.size() == 0;
+	return getContentSize() == 0;
 }
 size_t ABB::DisasmFile::getNumLines() const {
 	return lines.size();
@@ -510,61 +1297,54 @@ size_t ABB::DisasmFile::getNumLines() const {
 
 
 ABB::Console::addrmcu_t ABB::DisasmFile::getPrevActualAddr(size_t line) const {
-	if (addrs.size() == 0)
+	if (prevActualAddrs.size() == 0)
 		return 0;
 
-	if (line >= addrs.size())
-		line = addrs.size() - 1;
-
-	while (true) {
-		if (addrIsActualAddr(addrs[line]))
-			return addrs[line];
+	if (line >= prevActualAddrs.size())
+		line = prevActualAddrs.size() - 1;
 
-		if (line == 0)
-			break;
-		line--;
-	}
-	return 0;
+	return prevActualAddrs[line];
 }
 ABB::Console::addrmcu_t ABB::DisasmFile::getNextActualAddr(size_t line) const {
-	const size_t line_orig = line;
-	while (line < lines.size()) {
-		if (addrIsActualAddr(addrs[line]))
-			return addrs[line];
+	if (line >= nextActualAddrs.size())
+		return getPrevActualAddr(line); // there is nothing after the end, so we search before it
 
-		line++;
-	}
-	// we didnt find anything, so now we search before the given line
-	return getPrevActualAddr(line_orig);
+	return nextActualAddrs[line];
 }
 
-size_t ABB::DisasmFile::PassingBranchs::sizeBytes() const {
-	size_t sum = 0;
-
-	sum += DataUtils::approxSizeOf(passing);
-	sum += sizeof(startLine);
-	sum += DataUtils::approxSizeOf(occupied);
+ABB::DisasmFile::BranchIndList ABB::DisasmFile::getPassingBranches(const PassingBranchs& pb) const {
+	const uint32_t* start = passingBranchesArena.data() + pb.passingStart;
+	return { start, start + pb.passingLen };
+}
 
-	return sum;
+size_t ABB::DisasmFile::contentSizeBytes() const {
+	return DataUtils::approxSizeOf(ownedContent);
 }
 
 size_t ABB::DisasmFile::sizeBytes() const {
 	size_t sum = 0;
 
-	sum += DataUtils::approxSizeOf(content);
+	sum += contentSizeBytes();
+	sum += sizeof(mappedContent);
+	sum += sizeof(mappedContentLen);
 	sum += DataUtils::approxSizeOf(lines);
 	sum += DataUtils::approxSizeOf(addrs);
 	sum += DataUtils::approxSizeOf(isLineProgram); // [linenumber] = true if line is part of the program, false if not (like data, empty...)
 	sum += DataUtils::approxSizeOf(labels); // [symbAddress] = linenumber
+	sum += DataUtils::approxSizeOf(addrToLine);
+	sum += DataUtils::approxSizeOf(prevActualAddrs);
+	sum += DataUtils::approxSizeOf(nextActualAddrs);
+	sum += DataUtils::approxSizeOf(instTokens);
+	sum += DataUtils::approxSizeOf(instTokenStarts);
 
 	sum += DataUtils::approxSizeOf(branchRoots); // , [](const BranchRoot& v) { CU_UNUSED(v); return sizeof(BranchRoot); }
 	sum += DataUtils::approxSizeOf(branchRootInds); // [linenumber] = ind to branch root object of this line (-1 if line is not a branchroot)
 
-	sum += DataUtils::approxSizeOf(passingBranchesVec[0]);
-
 	sum += DataUtils::approxSizeOf(passingBranchesVec);
 	sum += DataUtils::approxSizeOf(passingBranchesInds);  // [linenumber] = ind to pass to passingBranchesVec to get: branchRootInd of all branches passing this address/line
+	sum += DataUtils::approxSizeOf(passingBranchesArena);
 	sum += sizeof(maxBranchDisplayDepth);
+	sum += DataUtils::approxSizeOf(unresolvedBranches);
 
 	return sum;
 }
\ No newline at end of file
@@ -8,10 +8,14 @@
 #include <set>
 #include <functional>
 #include <memory>
+#include <atomic>
+#include <utility>
 
 #include "CompilerUtils.h"
+#include "LogUtils.h"
 
 #include "../Console.h"
+#include "mappedFile.h"
 
 namespace ABB {
 	class DisasmFile{
@@ -25,12 +29,50 @@ namespace ABB {
 		};
 
 
-		std::string content;
+	private:
+		std::string ownedContent; // content if it isnt mapped
+		std::shared_ptr<const utils::MappedFile> mappedContent; // only set during loadMapped, content is the first mappedContentLen bytes of this
+		size_t mappedContentLen = 0;
+	public:
+		const char* getContent() const;
+		size_t getContentSize() const;
+
 		std::vector<size_t> lines; // [linenumber] = start index of line
 		std::vector<Console::addrmcu_t> addrs; // [linenumber] = PC address
 		std::vector<bool> isLineProgram; // [linenumber] = true if line is part of the program, false if not (like data, empty...)
 		std::map<uint16_t, size_t> labels; // [symbAddress] = linenumber
 
+		std::vector<uint32_t> addrToLine; // [flash word address] = line of that address, or of the next address after it if it isnt present
+		std::vector<Console::addrmcu_t> prevActualAddrs; // [linenumber] = nearest actual address at or before this line (0 if there is none)
+		std::vector<Console::addrmcu_t> nextActualAddrs; // [linenumber] = nearest actual address at or after this line (or before it if there is none)
+
+		// instruction lines get parsed once when loading, so drawing them only needs to format (all positions are offsets from the line start)
+		struct InstTokens {
+			struct Param {
+				uint16_t start = 0; // [start, start+len) is the param like it gets displayed (with its trailing comma)
+				uint8_t len = 0;
+				Console::ParamInfo info = { Console::ParamType_None, 0 }; // from Console::disassembler_parseParam
+			};
+			static constexpr size_t maxParams = 3;
+
+			uint16_t word = 0; // raw instruction
+			uint16_t word2 = 0;
+			uint16_t nameEnd = 0; // the name starts at FileConsts::instBytesEnd, 0 if this isnt an instruction line
+			uint16_t commentStart = 0; // 0 if there is no comment
+			uint16_t symbolStart = 0; // "<symbol+off>" inside the comment, 0 if there is none
+			uint16_t symbolNameEnd = 0;
+			uint16_t symbolEnd = 0;
+			uint32_t symbolOff = -1; // -1 if the symbol has no offset
+			uint8_t numParams = 0;
+			Param params[maxParams];
+
+			bool isInst() const { return nameEnd != 0; }
+		};
+		// only instruction lines have tokens, so they are stored densely in line order
+		std::vector<InstTokens> instTokens;
+		std::vector<uint32_t> instTokenStarts; // [linenumber] = ind into instTokens of the first instruction line at or after this line (one entry more than lines)
+		const InstTokens& getInstTokens(size_t line) const; // tokens that arent an instruction (isInst() is false) if the line has none
+
 
 
 		struct BranchRoot {
@@ -46,20 +88,31 @@ namespace ABB {
 		std::vector<BranchRoot> branchRoots; // list of all branch roots
 		std::vector<size_t> branchRootInds; // [linenumber] = ind to branch root object of this line (-1 if line is not a branchroot)
 		struct PassingBranchs {
-			std::vector<size_t> passing;
 			size_t startLine;
-			static constexpr size_t bitArrSize = 2048;
-			std::array<bool,bitArrSize> occupied;
-
-			size_t sizeBytes() const;
+			uint32_t passingStart; // range in passingBranchesArena
+			uint32_t passingLen;
 		};
-		std::vector<PassingBranchs> passingBranchesVec;
-		std::vector<size_t> passingBranchesInds;  // [linenumber] = ind to pass to passingBranchesVec to get: branchRootInd of all branches passing this address/line
+		struct BranchIndList {
+			const uint32_t* first;
+			const uint32_t* last;
+
+			const uint32_t* begin() const { return first; }
+			const uint32_t* end() const { return last; }
+			size_t size() const { return last - first; }
+			uint32_t operator[](size_t i) const { return first[i]; }
+		};
+		std::vector<PassingBranchs> passingBranchesVec; // one entry for every run of lines that are passed by the same branches
+		std::vector<uint32_t> passingBranchesInds;  // [linenumber] = ind to pass to passingBranchesVec to get: branchRootInd of all branches passing this address/line
+		std::vector<uint32_t> passingBranchesArena; // branchRootInds of all passingBranchesVec entries, identical lists are only stored once
+		BranchIndList getPassingBranches(const PassingBranchs& pb) const;
 		size_t maxBranchDisplayDepth = 0;
 		constexpr static size_t maxBranchShowDist = 256;
 
 		
 	private:
+		// {line, dest} of every jump whose destination isnt a line (yet), sorted by line.
+		// Redisassembling can make the destination appear, so they get checked again then
+		std::vector<std::pair<size_t, Console::addrmcu_t>> unresolvedBranches;
 
 		static constexpr Console::addrmcu_t Addrs_notAnAddr = -1;
 		static constexpr Console::addrmcu_t Addrs_symbolLabel = -2;
@@ -76,14 +129,48 @@ namespace ABB {
 		static uint16_t getAddrFromLine(const char* start, const char* end);
 		static bool isValidHexAddr(const char* start, const char* end);
 		void addAddrToList(const char* start, const char* end, size_t lineInd);
+		void buildAddrTables();
+		static InstTokens tokenizeLine(Console* cons, const char* start, const char* end, Console::addrmcu_t addr);
+		bool hasInstTokens(size_t line) const;
+		void tokenizeLines(Console* cons, size_t from, size_t to, std::vector<InstTokens>* out) const; // appends the tokens of all instruction lines in [from,to)
+
+		// returns false if the line doesnt branch anywhere (valid), missingDest gets set if it does but the destination isnt a line
+		bool getBranchRootOfLine(Console* cons, size_t line, BranchRoot* branchRoot, Console::addrmcu_t* missingDest = nullptr) const;
+		bool processBranches(Console* cons);
+		void buildPassingBranches();
+		void assignBranchDisplayDepths();
+		bool processContent(Console* cons);
+
+		size_t getLineInstLen(size_t line) const; // in bytes
+		static std::string genInstLine(Console* cons, Console::addrmcu_t addr, uint16_t word, uint16_t word2, size_t len);
+		size_t redisassembleRegion(Console* cons, Console::addrmcu_t from, Console::addrmcu_t to, bool* updated); // returns where to continue (-1 if done)
+		void updateAddrTablesAfterSplice(size_t startLine, size_t oldEndLine, size_t newEndLine);
+		void updateBranchesAfterSplice(Console* cons, size_t startLine, size_t oldEndLine, size_t newEndLine);
+	public:
+		// lets a load running on another thread report its progress and be canceled
+		struct LoadControl {
+			std::atomic<float> progress{0}; // [0,1]
+			std::atomic<bool> cancel{false};
 
-		void processBranches(Console* cons);
-		size_t processBranchesRecurse(size_t i, size_t depth = 0); //const BitArray<256>&
-		void processContent(Console* cons);
+			float progressFrom = 0; // range of progress that this load covers (loading might only be a part of a bigger task)
+			float progressTo = 1;
+
+			std::pair<LogUtils::LogCallB, void*> logContext = {nullptr, nullptr}; // if set, logs go here instead of the global log target
+		};
+	private:
+		LoadControl* loadCtrl = nullptr; // only set during loadSrc
+		bool updateLoadProgress(float progress); // returns false if the load should be canceled
 	public:
 
+		bool loadSrc(Console* cons, const char* str, const char* strEnd = NULL, LoadControl* ctrl = nullptr); // returns false if canceled
+		// parses the mapped file directly and only copies the content out of it once that is done (so the mapping isnt kept around,
+		// the file might get truncated or rewritten in the meantime), len can be used to only load the start of the file (has to end on a line end)
+		bool loadMapped(Console* cons, std::shared_ptr<const utils::MappedFile> file, size_t len = -1, LoadControl* ctrl = nullptr);
 
-		void loadSrc(Console* cons, const char* str, const char* strEnd = NULL);
+		// decodes the instructions in [from,to] (byte addresses) again from the flash of cons and splices them in (data is left as it is), 
+		// returns false if there was nothing to update (e.g. the range isnt disassembled).
+		// Only the edited lines and the tables around them get rebuilt, everything after them is moved
+		bool redisassembleRange(Console* cons, Console::addrmcu_t from, Console::addrmcu_t to);
 
 		// helpers/utility
 		size_t getLineIndFromAddr(Console::addrmcu_t Addr) const; // if addr not present, returns the index of the pos to insert at
@@ -93,19 +180,26 @@ namespace ABB {
 		Console::addrmcu_t getPrevActualAddr(size_t line) const;
 		Console::addrmcu_t getNextActualAddr(size_t line) const;
 
+		size_t contentSizeBytes() const; // memory used by the content
 		size_t sizeBytes() const;
 	};
 }
 
 namespace DataUtils {
 	inline size_t approxSizeOf(const ABB::DisasmFile::PassingBranchs& v) {
-		return v.sizeBytes();
+		CU_UNUSED(v);
+		return sizeof(ABB::DisasmFile::PassingBranchs);
 	}
 
 	inline size_t approxSizeOf(const ABB::DisasmFile::BranchRoot& v) {
 		CU_UNUSED(v);
 		return sizeof(ABB::DisasmFile::BranchRoot);
 	}
+
+	inline size_t approxSizeOf(const ABB::DisasmFile::InstTokens& v) {
+		CU_UNUSED(v);
+		return sizeof(ABB::DisasmFile::InstTokens);
+	}
 }
 
 
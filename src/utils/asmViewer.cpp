@@ -27,7 +27,72 @@ ABB::utils::AsmViewer::Settings ABB::utils::AsmViewer::settings;
 ABB::utils::AsmViewer::SyntaxColors ABB::utils::AsmViewer::syntaxColors;
 const ABB::utils::AsmViewer::SyntaxColors ABB::utils::AsmViewer::defSyntaxColors;
 
-void ABB::utils::AsmViewer::drawLine(const char* lineStart, const char* lineEnd, size_t line_no, size_t PCAddr, ImRect& lineRect, bool* hasAlreadyClicked, Console* mcu, const EmuUtils::SymbolTable* symbolTable) {
+static void formatCycles(char* buf, size_t bufSize, uint64_t cycs) {
+	if (cycs < 100000)
+		snprintf(buf, bufSize, "%" PRIu64, cycs);
+	else if (cycs < 100000000)
+		snprintf(buf, bufSize, "%.1fk", cycs / 1000.0);
+	else if (cycs < 100000000000)
+		snprintf(buf, bufSize, "%.1fM", cycs / 1000000.0);
+	else
+		snprintf(buf, bufSize, "%.1fG", cycs / 1000000000.0);
+}
+uint64_t ABB::utils::AsmViewer::getFuncCycles(size_t labelLine, Console* mcu) const {
+	uint64_t sum = 0;
+	for (size_t l = labelLine + 1; l < file.getNumLines(); l++) {
+		Console::addrmcu_t addr = file.addrs[l];
+		if (DisasmFile::addrIsSymbol(addr))
+			break;
+		if (DisasmFile::addrIsActualAddr(addr) && addr/2 < mcu->programSize())
+			sum += mcu->analytics_getPCCycles(addr/2);
+	}
+	return sum;
+}
+void ABB::utils::AsmViewer::drawCycleGutter(size_t line_no, Console* mcu) {
+	const Console::addrmcu_t lineAddr = file.addrs[line_no];
+	const float width = ImGui::CalcTextSize(" ").x * settings.cycleGutterChars;
+	const ImVec2 pos = ImGui::GetCursorScreenPos();
+
+	uint64_t cycs = 0;
+	bool isFuncTotal = false;
+	if (DisasmFile::addrIsActualAddr(lineAddr)) {
+		if(lineAddr/2 < mcu->programSize())
+			cycs = mcu->analytics_getPCCycles(lineAddr/2);
+	}
+	else if (DisasmFile::addrIsSymbol(lineAddr)) {
+		cycs = getFuncCycles(line_no, mcu);
+		isFuncTotal = true;
+	}
+
+	ImGuiExt::Rect((ImGuiID)(line_no + 91283741), ImVec4{ 0,0,0,0 }, {width, ImGui::GetTextLineHeight()});
+	if (cycs > 0) {
+		const float perc = cyclesTotal > 0 ? (float)((double)cycs / (double)cyclesTotal) * 100 : 0;
+
+		char buf[32];
+		char cycBuf[16];
+		formatCycles(cycBuf, sizeof(cycBuf), cycs);
+		snprintf(buf, sizeof(buf), "~%6s %5.1f%%", cycBuf, perc);
+		ImGui::GetWindowDrawList()->AddText(pos, ImColor(isFuncTotal ? syntaxColors.syntaxLabelText : syntaxColors.asmComment), buf);
+
+		if (ImGui::IsItemHovered()) {
+			ImGui::BeginTooltip();
+			if (isFuncTotal) {
+				ImGui::Text("Function total: ~%s cycles (estimated)", StringUtils::addThousandsSeperator(std::to_string(cycs).c_str()).c_str());
+			}
+			else {
+				const uint64_t cnt = mcu->analytics_getPCHeat(lineAddr/2);
+				ImGui::Text("~%s cycles (estimated)", StringUtils::addThousandsSeperator(std::to_string(cycs).c_str()).c_str());
+				ImGui::Text("%s executions (%.2f cycles each)", StringUtils::addThousandsSeperator(std::to_string(cnt).c_str()).c_str(), cnt > 0 ? (double)cycs/cnt : 0.0);
+			}
+			ImGui::Text("%.3f%% of all profiled cycles", perc);
+			ImGui::TextUnformatted("Taken branches and skips are inferred from the execution count of the next\ninstruction, so they are undercounted if that instruction is also a jump target");
+			ImGui::EndTooltip();
+		}
+	}
+	ImGui::SameLine();
+}
+
+void ABB::utils::AsmViewer::drawLine(const char* lineStart, const char* lineEnd, size_t line_no, size_t PCAddr, ImRect& lineRect, bool* hasAlreadyClicked, Console* mcu, const EmuUtils::SymbolTable* symbolTable, const SymbolIndex* symbolIndex) {
 	auto lineAddr = file.addrs[line_no];
 	ImDrawList* drawList = ImGui::GetWindowDrawList();
 
@@ -64,11 +129,16 @@ void ABB::utils::AsmViewer::drawLine(const char* lineStart, const char* lineEnd,
 			lineRect.Min = ImGui::GetCursorScreenPos();
 		}
 	}
+
+	if (settings.showCycles) {
+		drawCycleGutter(line_no, mcu);
+		lineRect.Min = ImGui::GetCursorScreenPos();
+	}
 	
 	ImGui::BeginGroup();
 
-	if(showLineHeat && DisasmFile::addrIsActualAddr(lineAddr)){
-		const uint64_t cnt = mcu->analytics_getPCHeat(lineAddr/2);
+	if(showLineHeat && DisasmFile::addrIsActualAddr(lineAddr) && lineAddr/2 < mcu->programSize()){
+		const uint64_t cnt = settings.showCycles ? mcu->analytics_getPCCycles(lineAddr/2) : mcu->analytics_getPCHeat(lineAddr/2);
 		if (cnt > 0) {
 			const float intensity = MathUtils::clamp((float)std::log(cnt) / 15, 0.05f, 1.f);
 			drawList->AddRectFilled(
@@ -93,9 +163,8 @@ void ABB::utils::AsmViewer::drawLine(const char* lineStart, const char* lineEnd,
 			ImGui::TextUnformatted(lineStart+DisasmFile::FileConsts::addrEnd, lineStart+DisasmFile::FileConsts::addrEndExt);
 			ImGui::SameLine();
 
-			bool isInstNotData = *(lineStart + 22) == '\t';
-			if (isInstNotData) { // is instruction
-				drawInst(lineStart, lineEnd, hasAlreadyClicked, mcu, symbolTable);
+			if (file.isLineProgram[line_no]) { // is instruction
+				drawInst(lineStart, lineEnd, file.getInstTokens(line_no), hasAlreadyClicked, mcu, symbolTable, symbolIndex);
 			}
 			else {
 				drawData(lineStart, lineEnd);
@@ -125,49 +194,37 @@ void ABB::utils::AsmViewer::drawLine(const char* lineStart, const char* lineEnd,
 		selectedLine = line_no;
 	}
 }
-void ABB::utils::AsmViewer::drawInst(const char* lineStart, const char* lineEnd, bool* hasAlreadyClicked, Console* mcu, const EmuUtils::SymbolTable* symbolTable) {
+void ABB::utils::AsmViewer::drawInst(const char* lineStart, const char* lineEnd, const DisasmFile::InstTokens& tokens, bool* hasAlreadyClicked, Console* mcu, const EmuUtils::SymbolTable* symbolTable, const SymbolIndex* symbolIndex) {
 	constexpr size_t instBytesStart = DisasmFile::FileConsts::instBytesStart;
 	constexpr size_t instBytesEnd = DisasmFile::FileConsts::instBytesEnd;
 
-	const char* const instNameStart = lineStart + 23;
-	const char* const paramTabOff = StringUtils::findCharInStr('\t', instNameStart, lineEnd);
-	const bool hasParams = paramTabOff != nullptr;
-	const char* const instNameEnd = hasParams ? paramTabOff : lineEnd;
-	const char* const paramStart = instNameEnd;
-
-	
+	if (!tokens.isInst()) { // line too long to be tokenized
+		ImGuiExt::TextColored(syntaxColors.rawInstBytes, lineStart + instBytesStart, lineEnd);
+		return;
+	}
 
 	// raw instruction bytes
 	ImGuiExt::TextColored(syntaxColors.rawInstBytes, lineStart + instBytesStart, lineStart + instBytesEnd);
 	if(ImGui::IsItemHovered()){
-		uint16_t word = (	StringUtils::hexStrToUIntLen<uint16_t>(lineStart+instBytesStart,   2)) |
-						(	StringUtils::hexStrToUIntLen<uint16_t>(lineStart+instBytesStart+3, 2) << 8);
-		uint16_t word2 = 0;
-		if(*(lineStart+instBytesStart+3+3) != ' ') {
-			word2 = (	StringUtils::hexStrToUIntLen<uint16_t>(lineStart+instBytesStart+3+3,   2)) |
-					(	StringUtils::hexStrToUIntLen<uint16_t>(lineStart+instBytesStart+3+3+3, 2) << 8);
-		}
 		popFileStyle();
-		ImGui::SetTooltip("%s",mcu->disassembler_disassembleRaw(word, word2).c_str());
+		ImGui::SetTooltip("%s",mcu->disassembler_disassembleRaw(tokens.word, tokens.word2).c_str());
 		pushFileStyle();
 	}
 	ImGui::SameLine();
 
 	float xOffStart = ImGui::GetCursorPosX();
 	// instruction name
-	ImGuiExt::TextColored(syntaxColors.instName, lineStart+instBytesEnd, instNameEnd);
+	ImGuiExt::TextColored(syntaxColors.instName, lineStart+instBytesEnd, lineStart+tokens.nameEnd);
 
 
-	if (hasParams) {
+	if (tokens.numParams > 0) {
 		ImGui::SameLine();
 		ImGui::SetCursorPosX(xOffStart + ImGui::CalcTextSize("\t AAAA").x + 10); // make offset uniform
 		const float xOffInst = ImGui::GetCursorPosX();
 
-		const char* const commentCharPos = StringUtils::findCharInStr(';', paramStart, lineEnd);
-
-		drawInstParams(paramStart, commentCharPos ? commentCharPos : lineEnd, lineStart+instBytesEnd+2, instNameEnd, lineStart, lineStart+DisasmFile::FileConsts::addrEnd, hasAlreadyClicked, mcu, symbolTable);
+		drawInstParams(lineStart, tokens, hasAlreadyClicked, mcu, symbolTable, symbolIndex);
 
-		if(commentCharPos){
+		if(tokens.commentStart){
 			ImGui::SameLine();
 
 			{
@@ -177,126 +234,111 @@ void ABB::utils::AsmViewer::drawInst(const char* lineStart, const char* lineEnd,
 			}
 			
 
-			const char* const symbolPos = StringUtils::findCharInStr('<', commentCharPos, lineEnd);
-			const char* const symbolEndPos = StringUtils::findCharInStr('>', commentCharPos, lineEnd);
-			bool hasSymbol = symbolPos && symbolEndPos;
+			const char* const commentStart = lineStart + tokens.commentStart;
+			const bool hasSymbol = tokens.symbolStart != 0;
 
-			ImGuiExt::TextColored(syntaxColors.asmComment, commentCharPos, hasSymbol ? symbolPos : lineEnd);
+			ImGuiExt::TextColored(syntaxColors.asmComment, commentStart, hasSymbol ? lineStart + tokens.symbolStart : lineEnd);
 			if (hasSymbol) {
 				ImGui::SameLine();
 
-				drawSymbolComment(lineStart, lineEnd, symbolPos, symbolEndPos+1, hasAlreadyClicked, symbolTable);
+				drawSymbolComment(lineStart, tokens, hasAlreadyClicked, symbolTable);
 
 				// draw rest of comment
 				ImGui::SameLine();
-				ImGuiExt::TextColored(syntaxColors.asmComment, symbolEndPos+1, lineEnd);
+				ImGuiExt::TextColored(syntaxColors.asmComment, lineStart + tokens.symbolEnd, lineEnd);
 			}
 
 		}
 	}
 }
-void ABB::utils::AsmViewer::drawInstParams(const char* start, const char* end, const char* instStart, const char* instEnd, const char* addrStart, const char* addrEnd, bool* hasAlreadyClicked, Console* mcu, const EmuUtils::SymbolTable* symbolTable) {
+void ABB::utils::AsmViewer::drawInstParams(const char* lineStart, const DisasmFile::InstTokens& tokens, bool* hasAlreadyClicked, Console* mcu, const EmuUtils::SymbolTable* symbolTable, const SymbolIndex* symbolIndex) {
 	float xOff = ImGui::GetCursorPosX();
 
-	size_t paramCnt = 1;
-	for (const char* sptr = start; sptr < end; sptr++)
-		if (*sptr == ',')
-			paramCnt++;
-
-	const char* nextParamOff = start;
-	for (size_t i = 0; i < paramCnt; i++) {
-		const char* const comma = StringUtils::findCharInStr(',', nextParamOff, end);
-		const char* const paramEnd = (comma != nullptr) ? comma + 1 : end;
-
-		auto stripped = StringUtils::stripString(nextParamOff, paramEnd);
+	for (size_t i = 0; i < tokens.numParams; i++) {
+		const DisasmFile::InstTokens::Param& param = tokens.params[i];
+		const char* const paramStart = lineStart + param.start;
+		const char* const paramEnd = paramStart + param.len;
 
-		ImGuiExt::TextColored(syntaxColors.instParams, stripped.first, stripped.second);
+		ImGuiExt::TextColored(syntaxColors.instParams, paramStart, paramEnd);
 
-		if (i != paramCnt - 1)
+		if (i != (size_t)tokens.numParams - 1)
 			ImGui::SameLine();
 
-		if (ImGui::IsItemHovered()) {
-			std::string param = std::string(stripped.first, stripped.second);
-
-			if (param.size() > 0) {
-				if (param[param.size() - 1] == ',')
-					param = param.substr(0, param.size() - 1);
-
-				popFileStyle();
+		if (ImGui::IsItemHovered() && param.len > 0) {
+			const int nameLen = (int)(param.len - (*(paramEnd - 1) == ',' ? 1 : 0));
 
-				uint32_t addr = StringUtils::hexStrToUInt<uint32_t>(addrStart, addrEnd);
+			popFileStyle();
 
-				auto info = mcu->getParamInfo(param.c_str(), param.c_str() + param.size(), instStart, instEnd, addr);
-				switch (info.type) {
-					case Console::ParamType_Register:
-					{
-						ImGui::BeginTooltip();
+			auto info = mcu->getParamInfo(param.info);
+			switch (info.type) {
+				case Console::ParamType_Register:
+				{
+					ImGui::BeginTooltip();
 
-						ImGui::Text("%s: 0x%02x = %u", param.c_str(), info.val, info.val);
+					ImGui::Text("%.*s: 0x%02x = %u", nameLen, paramStart, info.val, info.val);
 
-						ImGui::EndTooltip();
-						break;
-					}
-
-					case Console::ParamType_RamAddr: // fallthrough
-					case Console::ParamType_RamAddrRegister:
-					case Console::ParamType_RomAddr:
-					case Console::ParamType_RomAddrRegister:
-					{
-						ImGui::BeginTooltip();
+					ImGui::EndTooltip();
+					break;
+				}
 
-						auto addr = info.val;
-						ImGui::Text("0x%04x => %u", addr, addr);
+				case Console::ParamType_RamAddr: // fallthrough
+				case Console::ParamType_RamAddrRegister:
+				case Console::ParamType_RomAddr:
+				case Console::ParamType_RomAddrRegister:
+				{
+					ImGui::BeginTooltip();
 
-						bool isRam = info.type == Console::ParamType_RamAddr || info.type == Console::ParamType_RamAddrRegister;
+					auto addr = info.val;
+					ImGui::Text("0x%04x => %u", addr, addr);
 
-						const EmuUtils::SymbolTable::Symbol* symbol = symbolTable->getSymbolByValue(addr, isRam ? symbolTable->getSymbolsRam() : symbolTable->getSymbolsRom());
-						if (symbol) {
-							ImGui::Separator();
-							SymbolBackend::drawSymbol(symbol, addr);
-						}
+					bool isRam = info.type == Console::ParamType_RamAddr || info.type == Console::ParamType_RamAddrRegister;
 
-						ImGui::EndTooltip();
-						break;
+					const auto& list = isRam ? symbolTable->getSymbolsRam() : symbolTable->getSymbolsRom();
+					const EmuUtils::SymbolTable::Symbol* symbol = symbolIndex ? symbolIndex->getSymbolByValue(addr, list) : symbolTable->getSymbolByValue(addr, list);
+					if (symbol) {
+						ImGui::Separator();
+						SymbolBackend::drawSymbol(symbol, addr);
 					}
 
-					case Console::ParamType_Literal:
-					{
-						ImGui::BeginTooltip();
-						ImGui::Text("%s => %u", param.c_str(), info.val);
-						ImGui::EndTooltip();
-						break;
-					}
+					ImGui::EndTooltip();
+					break;
 				}
 
-				if (ImGui::GetIO().KeyCtrl) {
-					{ // draw underline
-						float height = ImGui::GetItemRectMax().y;
-						ImGui::GetWindowDrawList()->AddLine({ ImGui::GetItemRectMin().x,height }, ImGui::GetItemRectMax(), ImColor(syntaxColors.instParams));
-					}
-					
-					if (!*hasAlreadyClicked && ImGui::IsItemClicked()) {
-						*hasAlreadyClicked = true;
-						if (info.type == Console::ParamType_RomAddr || info.type == Console::ParamType_RomAddrRegister) {
-							scrollToAddr(info.val, true);
-						}
-					}
+				case Console::ParamType_Literal:
+				{
+					ImGui::BeginTooltip();
+					ImGui::Text("%.*s => %u", nameLen, paramStart, info.val);
+					ImGui::EndTooltip();
+					break;
 				}
+			}
 
-				pushFileStyle();
+			if (ImGui::GetIO().KeyCtrl) {
+				{ // draw underline
+					float height = ImGui::GetItemRectMax().y;
+					ImGui::GetWindowDrawList()->AddLine({ ImGui::GetItemRectMin().x,height }, ImGui::GetItemRectMax(), ImColor(syntaxColors.instParams));
+				}
+				
+				if (!*hasAlreadyClicked && ImGui::IsItemClicked()) {
+					*hasAlreadyClicked = true;
+					if (info.type == Console::ParamType_RomAddr || info.type == Console::ParamType_RomAddrRegister) {
+						scrollToAddr(info.val, true);
+					}
+				}
 			}
+
+			pushFileStyle();
 		}
 
 		ImGui::SetCursorPosX(std::max(ImGui::GetCursorPosX(), xOff + ImGui::CalcTextSize("AAA,").x + 5));
 		xOff = ImGui::GetCursorPosX();
-
-		nextParamOff = comma+1;
 	}
 }
-void ABB::utils::AsmViewer::drawSymbolComment(const char* lineStart, const char* lineEnd, const char* symbolStartOff, const char* symbolEndOff, bool* hasAlreadyClicked, const EmuUtils::SymbolTable* symbolTable) {
+void ABB::utils::AsmViewer::drawSymbolComment(const char* lineStart, const DisasmFile::InstTokens& tokens, bool* hasAlreadyClicked, const EmuUtils::SymbolTable* symbolTable) {
+	const char* const symbolStartOff = lineStart + tokens.symbolStart;
+	const char* const symbolEndOff = lineStart + tokens.symbolEnd;
 	const char* const symbolNameStartOff = symbolStartOff+1;
-	const char* const plusPos = StringUtils::findCharInStr('+', symbolStartOff, lineEnd);
-	const char* const symbolNameEndOff = (plusPos!=nullptr) ? plusPos : (symbolEndOff-1);
+	const char* const symbolNameEndOff = lineStart + tokens.symbolNameEnd;
 	const bool hasOffset = symbolNameEndOff != symbolEndOff - 1;
 	
 	//ImGuiExt::TextColored(syntaxColors.asmCommentSymbol, lineStart+symbolStartOff, lineStart+symbolEndOff); // simple display
@@ -362,9 +404,8 @@ void ABB::utils::AsmViewer::drawSymbolComment(const char* lineStart, const char*
 				auto res = file.labels.find((Console::addrmcu_t)symbol->value);
 				if (res != file.labels.end()) {
 					if (io.KeyShift && hasOffset) {
-						size_t off = (size_t)StringUtils::numStrToUInt<size_t>(symbolNameEndOff + 1, symbolEndOff - 1);
-						if (off != (size_t)-1)
-							selectedLine = file.getLineIndFromAddr((Console::addrmcu_t)(symbol->value + off));
+						if (tokens.symbolOff != (uint32_t)-1)
+							selectedLine = file.getLineIndFromAddr((Console::addrmcu_t)(symbol->value + tokens.symbolOff));
 						else
 							selectedLine = res->second;
 					}
@@ -441,8 +482,8 @@ void ABB::utils::AsmViewer::drawBranchVis(size_t lineStart, size_t lineEnd, cons
 				break;
 			}
 
-			for (size_t i = 0; i < pb.passing.size(); i++) {
-				branchRootInds.insert(pb.passing[i]);
+			for (uint32_t b : file.getPassingBranches(pb)) {
+				branchRootInds.insert(b);
 			}
 		}
 	}
@@ -552,7 +593,7 @@ void ABB::utils::AsmViewer::drawBranchVis(size_t lineStart, size_t lineEnd, cons
 			);
 	}
 }
-void ABB::utils::AsmViewer::drawFile(uint16_t PCAddr, Console* mcu, const EmuUtils::SymbolTable* symbolTable) {
+void ABB::utils::AsmViewer::drawFile(uint16_t PCAddr, Console* mcu, const EmuUtils::SymbolTable* symbolTable, const SymbolIndex* symbolIndex) {
 	if(file.isEmpty())
 		return;
 
@@ -566,6 +607,13 @@ void ABB::utils::AsmViewer::drawFile(uint16_t PCAddr, Console* mcu, const EmuUti
 		if (ImGui::IsWindowHovered() && ImGui::IsMouseClicked(ImGuiMouseButton_Right))
 			selectedLine = -1;
 
+		if (settings.showCycles && mcu) {
+			cyclesTotal = 0;
+			for (Console::pc_t pc = 0; pc < mcu->programSize(); pc++) {
+				cyclesTotal += mcu->analytics_getPCCycles(pc);
+			}
+		}
+
 		if (showScollBarHints)
 			decorateScrollBar(PCAddr, mcu);
 
@@ -603,12 +651,12 @@ void ABB::utils::AsmViewer::drawFile(uint16_t PCAddr, Console* mcu, const EmuUti
 				lineEnd = clipper.DisplayEnd;
 				firstLineY = ImGui::GetCursorScreenPos().y;
 				for (int line_no = clipper.DisplayStart; line_no < clipper.DisplayEnd; line_no++) {
-					const char* lineStart = file.content.c_str() + file.lines[line_no];
+					const char* lineStart = file.getContent() + file.lines[line_no];
 					const char* lineEnd;
 					if(((size_t)line_no+1) < file.getNumLines())
-						lineEnd = file.content.c_str() + file.lines[line_no+1];
+						lineEnd = file.getContent() + file.lines[line_no+1];
 					else
-						lineEnd = file.content.c_str() + file.content.size();
+						lineEnd = file.getContent() + file.getContentSize();
 
 					if (settings.showBranches) {
 						ImGui::SetCursorPosX(ImGui::GetCursorPosX() + lineXOff);
@@ -619,7 +667,7 @@ void ABB::utils::AsmViewer::drawFile(uint16_t PCAddr, Console* mcu, const EmuUti
 						{ImGui::GetCursorScreenPos().x + contentWidth, ImGui::GetCursorScreenPos().y + charSize.y}
 					);
 
-					drawLine(lineStart, lineEnd, line_no, PCAddr, lineRect, &hasAlreadyClicked, mcu, symbolTable);
+					drawLine(lineStart, lineEnd, line_no, PCAddr, lineRect, &hasAlreadyClicked, mcu, symbolTable, symbolIndex);
 				}
 			}
 			clipper.End();
@@ -669,7 +717,7 @@ void ABB::utils::AsmViewer::decorateScrollBar(uint16_t PCAddr, Console* mcu) {
 				
 				uint64_t sum = 0;
 				for(Console::pc_t j = startAddr/2; j<endAddr/2;j++){
-					sum += mcu->analytics_getPCHeat(j);
+					sum += settings.showCycles ? mcu->analytics_getPCCycles(j) : mcu->analytics_getPCHeat(j); // estimating the cycles isnt free, so only if they are shown anyways
 				}
 
 				if(sum > 0){
@@ -701,7 +749,10 @@ void ABB::utils::AsmViewer::loadSrc(Console* cons, const char* str, const char*
 	file.loadSrc(cons, str, strEnd);
 }
 void ABB::utils::AsmViewer::loadDisasmFile(const DisasmFile& file) {
-	abort();
+	this->file = file;
+}
+void ABB::utils::AsmViewer::loadDisasmFile(DisasmFile&& file) {
+	this->file = std::move(file);
 }
 
 size_t ABB::utils::AsmViewer::numOfDisasmLines(){
@@ -745,6 +796,7 @@ size_t ABB::utils::AsmViewer::sizeBytes() const {
 
 void ABB::utils::AsmViewer::drawSettings() {
 	ImGui::Checkbox("Show Breakpoints", &settings.showBreakpoints);
+	ImGui::Checkbox("Show Cycles (estimated)", &settings.showCycles);
 
 	ImGui::Separator();
 
@@ -13,6 +13,7 @@
 
 #include "DisasmFile.h"
 #include "SymbolTable.h"
+#include "symbolIndex.h"
 
 namespace ABB{
     namespace utils{
@@ -23,6 +24,7 @@ namespace ABB{
 
         private:
             float scrollSet = -1;
+            uint64_t cyclesTotal = 0; // sum of the (estimated) cycles of all PCs since the last reset, updated every frame
 
         public:
 
@@ -37,6 +39,9 @@ namespace ABB{
                 size_t maxBranchDepth = 16;
 
                 bool showBreakpoints = true;
+
+                bool showCycles = false; // off by default, summing up the cycles of the whole program every frame isnt free
+                static constexpr size_t cycleGutterChars = 14;
             };
             static Settings settings;
             
@@ -70,7 +75,8 @@ namespace ABB{
 
             void loadSrc(Console* cons, const char* str, const char* strEnd = NULL);
             void loadDisasmFile(const DisasmFile& file);
-            void drawFile(uint16_t PCAddr, Console* cons, const EmuUtils::SymbolTable* symbolTable);
+            void loadDisasmFile(DisasmFile&& file);
+            void drawFile(uint16_t PCAddr, Console* cons, const EmuUtils::SymbolTable* symbolTable, const SymbolIndex* symbolIndex = nullptr);
             void scrollToLine(size_t line, bool select = false);
             void scrollToAddr(Console::addrmcu_t addr, bool select = false);
 
@@ -80,10 +86,12 @@ namespace ABB{
 
             static void drawSettings();
         private:
-            void drawLine(const char* lineStart, const char* lineEnd, size_t line_no, size_t PCAddr, ImRect& lineRect, bool* hasAlreadyClicked, Console* mcu, const EmuUtils::SymbolTable* symbolTable);
-            void drawInst(const char* lineStart, const char* lineEnd, bool* hasAlreadyClicked, Console* mcu, const EmuUtils::SymbolTable* symbolTable);
-            void drawInstParams(const char* start, const char* end, const char* instStart, const char* instEnd, const char* addrStart, const char* addrEnd, bool* hasAlreadyClicked, Console* mcu, const EmuUtils::SymbolTable* symbolTable);
-            void drawSymbolComment(const char* lineStart, const char* lineEnd, const char* symbolStartOff, const char* symbolEndOff, bool* hasAlreadyClicked, const EmuUtils::SymbolTable* symbolTable);
+            void drawCycleGutter(size_t line_no, Console* mcu);
+            uint64_t getFuncCycles(size_t labelLine, Console* mcu) const;
+            void drawLine(const char* lineStart, const char* lineEnd, size_t line_no, size_t PCAddr, ImRect& lineRect, bool* hasAlreadyClicked, Console* mcu, const EmuUtils::SymbolTable* symbolTable, const SymbolIndex* symbolIndex);
+            void drawInst(const char* lineStart, const char* lineEnd, const DisasmFile::InstTokens& tokens, bool* hasAlreadyClicked, Console* mcu, const EmuUtils::SymbolTable* symbolTable, const SymbolIndex* symbolIndex);
+            void drawInstParams(const char* lineStart, const DisasmFile::InstTokens& tokens, bool* hasAlreadyClicked, Console* mcu, const EmuUtils::SymbolTable* symbolTable, const SymbolIndex* symbolIndex);
+            void drawSymbolComment(const char* lineStart, const DisasmFile::InstTokens& tokens, bool* hasAlreadyClicked, const EmuUtils::SymbolTable* symbolTable);
             void drawData(const char* lineStart, const char* lineEnd);
             void drawSymbolLabel(const char* lineStart, const char* lineEnd, const EmuUtils::SymbolTable* symbolTable);
 
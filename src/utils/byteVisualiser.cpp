@@ -17,6 +17,15 @@ void ABB::utils::ByteVisualiser::DrawByte(uint8_t byte, float width, float heigh
 	ImGuiExt::ImageRect(tex, width, height, { (float)(byte*3+1),1,1,8 });
 }
 
+void ABB::utils::ByteVisualiser::DrawBytes(ImDrawList* drawList, const ImVec2& pos, const uint8_t* bytes, size_t num, float width, float height) {
+	const float texWidth = (float)tex.width, texHeight = (float)tex.height;
+	for (size_t i = 0; i < num; i++) {
+		const float x = pos.x + width * i;
+		const float u = (float)(bytes[i]*3+1);
+		drawList->AddImage((ImTextureID)&tex, { x, pos.y }, { x + width, pos.y + height }, { u/texWidth, 1/texHeight }, { (u+1)/texWidth, 9/texHeight });
+	}
+}
+
 void ABB::utils::ByteVisualiser::update() {
 	Color* colData = (Color*)texImg.data;
 	for (size_t i = 0; i < 256; i++) {
@@ -2,7 +2,9 @@
 #define __ABB_UTILS_BYTEVISUALISER_H__
 
 #include "raylib.h"
+#include "imgui.h"
 #include <stdint.h>
+#include <stddef.h>
 
 namespace ABB {
 	namespace utils {
@@ -15,6 +17,8 @@ namespace ABB {
 			static void destroy();
 
 			static void DrawByte(uint8_t byte, float width, float height);
+			// draws num bytes next to each other starting at pos (all of them share one texture, so they get merged into one draw call)
+			static void DrawBytes(ImDrawList* drawList, const ImVec2& pos, const uint8_t* bytes, size_t num, float width, float height);
 		private:
 			static void update();
 		};
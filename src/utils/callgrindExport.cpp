@@ -0,0 +1,294 @@
+#include "callgrindExport.h"
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cinttypes>
+
+namespace ABB {
+	namespace utils {
+		namespace Callgrind {
+			struct SrcPos {
+				uint32_t file = 0;
+				uint32_t line = 0;
+			};
+
+			struct Call {
+				Console::pc_t site;
+				Console::pc_t dest;
+				uint64_t count;
+			};
+
+			struct Func {
+				std::string name;
+				uint64_t self[2] = {0,0}; // [0] = cycles, [1] = executions
+				uint64_t inclusive[2] = {0,0};
+				uint64_t callsInto = 0;
+				uint8_t state = 0; // 0 = not visited, 1 = in progress, 2 = done
+				std::vector<size_t> calls; // inds into calls vector
+			};
+
+			static bool parseSrcLocation(const char* start, const char* end, std::string* path, uint32_t* line);
+			static void calcInclusive(size_t funcInd, std::vector<Func>& funcs, const std::vector<Call>& calls, const std::vector<size_t>& funcOfPC);
+		}
+	}
+}
+
+// matches lines like "/path/to/file.cpp:123" or "C:\path\file.cpp:123 (discriminator 1)" (like objdump -l generates them)
+bool ABB::utils::Callgrind::parseSrcLocation(const char* start, const char* end, std::string* path, uint32_t* line) {
+	while (end > start && (*(end-1) == '\n' || *(end-1) == '\r' || *(end-1) == ' '))
+		end--;
+
+	if (end - start < 3 || *start == ' ' || *start == '\t')
+		return false;
+
+	{
+		constexpr const char discrStr[] = " (discriminator";
+		const char* discr = std::search(start, end, discrStr, discrStr + sizeof(discrStr) - 1);
+		if (discr != end)
+			end = discr;
+	}
+
+	const char* colon = nullptr;
+	for (const char* ptr = end - 1; ptr > start; ptr--) {
+		if (*ptr == ':') {
+			colon = ptr;
+			break;
+		}
+		if (*ptr < '0' || *ptr > '9')
+			return false;
+	}
+	if (colon == nullptr || colon + 1 == end)
+		return false;
+
+	bool hasSep = false;
+	for (const char* ptr = start; ptr < colon; ptr++) {
+		if (*ptr == '/' || *ptr == '\\') {
+			hasSep = true;
+			break;
+		}
+	}
+	if (!hasSep)
+		return false;
+
+	path->assign(start, colon);
+	*line = 0;
+	for (const char* ptr = colon + 1; ptr < end; ptr++)
+		*line = *line * 10 + (*ptr - '0');
+	return true;
+}
+
+void ABB::utils::Callgrind::calcInclusive(size_t funcInd, std::vector<Func>& funcs, const std::vector<Call>& calls, const std::vector<size_t>& funcOfPC) {
+	Func& func = funcs[funcInd];
+	if (func.state != 0)
+		return; // already done, or recursion (in which case the callee's cost is only counted as far as it is known)
+
+	func.state = 1;
+	func.inclusive[0] = func.self[0];
+	func.inclusive[1] = func.self[1];
+	for (size_t c : func.calls) {
+		const Call& call = calls[c];
+		const size_t calleeInd = funcOfPC[call.dest];
+		calcInclusive(calleeInd, funcs, calls, funcOfPC);
+
+		const Func& callee = funcs[calleeInd];
+		if (calleeInd == funcInd || callee.callsInto == 0)
+			continue;
+		for (size_t e = 0; e < 2; e++) {
+			funcs[funcInd].inclusive[e] += (uint64_t)((double)callee.inclusive[e] * call.count / callee.callsInto);
+		}
+	}
+	funcs[funcInd].state = 2;
+}
+
+std::string ABB::utils::Callgrind::genProfile(Console* cons, const EmuUtils::SymbolTable* symbolTable, const DisasmFile* srcMix, const char* srcMixName, const CallEdgeMap* observedCalls) {
+	const size_t numPCs = cons->programSize();
+	const uint8_t* flash = cons->flash_getData();
+	const size_t flashSize = cons->flash_size();
+	auto getWord = [&](size_t pc) -> uint16_t {
+		return pc*2+1 < flashSize ? (flash[pc*2] | (flash[pc*2+1] << 8)) : 0;
+	};
+
+	// source positions
+	std::vector<std::string> files = {"???"};
+	std::vector<SrcPos> srcPos(numPCs);
+	if (srcMix) {
+		std::unordered_map<std::string, uint32_t> fileInds;
+		const uint32_t listingFile = (uint32_t)files.size();
+		files.push_back(srcMixName ? srcMixName : "srcMix");
+
+		bool hasLocation = false;
+		SrcPos curr;
+		std::string path;
+		for (size_t l = 0; l < srcMix->getNumLines(); l++) {
+			const Console::addrmcu_t addr = srcMix->addrs[l];
+			const char* lineStart = srcMix->getContent() + srcMix->lines[l];
+			const char* lineEnd = srcMix->getContent() + ((l + 1 < srcMix->getNumLines()) ? srcMix->lines[l + 1] : srcMix->getContentSize());
+
+			if (DisasmFile::addrIsActualAddr(addr)) {
+				const size_t pc = addr / 2;
+				if (pc < numPCs && srcPos[pc].file == 0)
+					srcPos[pc] = hasLocation ? curr : SrcPos{ listingFile, (uint32_t)(l + 1) };
+			}
+			else if (DisasmFile::addrIsNotProgram(addr)) {
+				uint32_t line;
+				if (parseSrcLocation(lineStart, lineEnd, &path, &line)) {
+					auto res = fileInds.insert({ path, (uint32_t)files.size() });
+					if (res.second)
+						files.push_back(path);
+					curr = SrcPos{ res.first->second, line };
+					hasLocation = true;
+				}
+			}
+		}
+	}
+
+	// functions
+	std::vector<Func> funcs(1);
+	funcs[0].name = "???";
+	std::vector<size_t> funcOfPC(numPCs, 0);
+	if (symbolTable) {
+		std::unordered_map<const EmuUtils::SymbolTable::Symbol*, size_t> funcInds;
+		const SymbolIndex::Intervals intervals = SymbolIndex::Intervals::build(*symbolTable, symbolTable->getSymbolsRom());
+		SymbolIndex::Intervals::Cursor cursor(&intervals);
+		for (size_t pc = 0; pc < numPCs; pc++) {
+			const EmuUtils::SymbolTable::Symbol* symbol = cursor.getSymbol(pc * 2);
+			if (!symbol)
+				continue;
+
+			auto res = funcInds.insert({ symbol, funcs.size() });
+			if (res.second) {
+				funcs.push_back(Func());
+				funcs.back().name = symbol->hasDemangledName ? symbol->demangled : symbol->name;
+			}
+			funcOfPC[pc] = res.first->second;
+		}
+	}
+
+	// costs and calls
+	std::vector<Call> calls;
+	for (size_t pc = 0; pc < numPCs; pc++) {
+		const uint64_t cnt = cons->analytics_getPCHeat((Console::pc_t)pc);
+		if (cnt == 0)
+			continue;
+
+		Func& func = funcs[funcOfPC[pc]];
+		func.self[0] += cons->analytics_getPCCycles((Console::pc_t)pc);
+		func.self[1] += cnt;
+
+		const uint16_t word = getWord(pc);
+		if (!cons->disassembler_isCall(word))
+			continue;
+
+		const Console::pc_t dest = cons->disassembler_getJumpDests(word, getWord(pc + 1), (Console::pc_t)pc);
+		if (dest != (Console::pc_t)-1) {
+			if (dest < numPCs)
+				calls.push_back(Call{ (Console::pc_t)pc, dest, cnt });
+		}
+		else if (observedCalls) {
+			// indirect call, so we split the calls up between all observed destinations
+			const Console::addrmcu_t siteAddr = (Console::addrmcu_t)(pc * 2);
+			auto begin = observedCalls->lower_bound({ siteAddr, 0 });
+			uint64_t observedSum = 0;
+			for (auto it = begin; it != observedCalls->end() && it->first.first == siteAddr; it++)
+				observedSum += it->second;
+
+			for (auto it = begin; it != observedCalls->end() && it->first.first == siteAddr; it++) {
+				const size_t destPC = it->first.second / 2;
+				if (destPC < numPCs)
+					calls.push_back(Call{ (Console::pc_t)pc, (Console::pc_t)destPC, (uint64_t)((double)cnt * it->second / observedSum) });
+			}
+		}
+	}
+
+	for (size_t i = 0; i < calls.size(); i++) {
+		funcs[funcOfPC[calls[i].site]].calls.push_back(i);
+		funcs[funcOfPC[calls[i].dest]].callsInto += calls[i].count;
+	}
+	for (size_t i = 0; i < funcs.size(); i++) {
+		calcInclusive(i, funcs, calls, funcOfPC);
+	}
+
+	// output
+	std::string out;
+	out += "# callgrind format\n";
+	out += "version: 1\n";
+	out += "creator: ABB\n";
+	out += "positions: instr line\n";
+	out += "events: Cycles Ir\n";
+	{
+		uint64_t total[2] = {0,0};
+		for (const auto& func : funcs) {
+			total[0] += func.self[0];
+			total[1] += func.self[1];
+		}
+		out += "summary: " + std::to_string(total[0]) + " " + std::to_string(total[1]) + "\n";
+	}
+
+	std::vector<bool> fileNamed(files.size(), false);
+	std::vector<bool> funcNamed(funcs.size(), false);
+	auto fileStr = [&](uint32_t ind) {
+		std::string s = "(" + std::to_string(ind + 1) + ")";
+		if (!fileNamed[ind]) {
+			s += " " + files[ind];
+			fileNamed[ind] = true;
+		}
+		return s;
+	};
+	auto funcStr = [&](size_t ind) {
+		std::string s = "(" + std::to_string(ind + 1) + ")";
+		if (!funcNamed[ind]) {
+			s += " " + funcs[ind].name;
+			funcNamed[ind] = true;
+		}
+		return s;
+	};
+
+	size_t currFunc = (size_t)-1;
+	uint32_t currFile = (uint32_t)-1;
+	size_t callInd = 0;
+	char buf[128];
+	for (size_t pc = 0; pc < numPCs; pc++) {
+		const uint64_t cnt = cons->analytics_getPCHeat((Console::pc_t)pc);
+		if (cnt == 0)
+			continue;
+
+		if (funcOfPC[pc] != currFunc) {
+			currFunc = funcOfPC[pc];
+			currFile = srcPos[pc].file;
+			out += "\nfl=" + fileStr(currFile) + "\n";
+			out += "fn=" + funcStr(currFunc) + "\n";
+		}
+		else if (srcPos[pc].file != currFile) {
+			currFile = srcPos[pc].file;
+			out += "fi=" + fileStr(currFile) + "\n";
+		}
+
+		snprintf(buf, sizeof(buf), "0x%" PRIx64 " %" PRIu32 " %" PRIu64 " %" PRIu64 "\n", (uint64_t)pc * 2, srcPos[pc].line, cons->analytics_getPCCycles((Console::pc_t)pc), cnt);
+		out += buf;
+
+		// calls are sorted by site
+		while (callInd < calls.size() && calls[callInd].site < pc)
+			callInd++;
+		for (; callInd < calls.size() && calls[callInd].site == pc; callInd++) {
+			const Call& call = calls[callInd];
+			const size_t calleeInd = funcOfPC[call.dest];
+			const Func& callee = funcs[calleeInd];
+			if (call.count == 0 || callee.callsInto == 0)
+				continue;
+
+			out += "cfi=" + fileStr(srcPos[call.dest].file) + "\n";
+			out += "cfn=" + funcStr(calleeInd) + "\n";
+			snprintf(buf, sizeof(buf), "calls=%" PRIu64 " 0x%" PRIx64 " %" PRIu32 "\n", call.count, (uint64_t)call.dest * 2, srcPos[call.dest].line);
+			out += buf;
+			snprintf(buf, sizeof(buf), "0x%" PRIx64 " %" PRIu32 " %" PRIu64 " %" PRIu64 "\n", (uint64_t)pc * 2, srcPos[pc].line,
+				(uint64_t)((double)callee.inclusive[0] * call.count / callee.callsInto),
+				(uint64_t)((double)callee.inclusive[1] * call.count / callee.callsInto)
+			);
+			out += buf;
+		}
+	}
+
+	return out;
+}
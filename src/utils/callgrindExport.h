@@ -0,0 +1,35 @@
+#ifndef _ABB_UTIL_CALLGRINDEXPORT
+#define _ABB_UTIL_CALLGRINDEXPORT
+
+#include <string>
+#include <map>
+#include <utility>
+
+#include "../Console.h"
+#include "DisasmFile.h"
+#include "SymbolTable.h"
+#include "symbolIndex.h"
+
+namespace ABB {
+	namespace utils {
+		namespace Callgrind {
+			typedef std::map<std::pair<Console::addrmcu_t, Console::addrmcu_t>, uint64_t> CallEdgeMap; // [{call site addr, dest addr}] = times the call was observed
+
+			/*
+				Generates a profile in the callgrind format (for kcachegrind/qcachegrind) from the PC heat and cycles of cons.
+				Addresses get mapped to ROM symbols if symbolTable is given, and to source lines if srcMix is given
+				(if srcMix contains no "file:line" markers, the line in the srcMix itself is used).
+				Call counts are the PC heat of the call sites. The destinations of indirect calls are taken from observedCalls,
+				whose counts are only used as ratios to split up the calls of a site.
+			*/
+			std::string genProfile(
+				Console* cons,
+				const EmuUtils::SymbolTable* symbolTable = nullptr,
+				const DisasmFile* srcMix = nullptr, const char* srcMixName = nullptr,
+				const CallEdgeMap* observedCalls = nullptr
+			);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,198 @@
+#include "hexLoader.h"
+
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <atomic>
+#ifndef __EMSCRIPTEN__
+#include <thread>
+#endif
+
+#include "StringUtils.h"
+#include "CompilerUtils.h"
+
+#include "mappedFile.h"
+
+namespace {
+	struct NibbleTable {
+		uint8_t vals[256];
+
+		constexpr NibbleTable() : vals() {
+			for (size_t i = 0; i < 256; i++)
+				vals[i] = 0xFF;
+			for (uint8_t i = 0; i < 10; i++)
+				vals['0' + i] = i;
+			for (uint8_t i = 0; i < 6; i++) {
+				vals['A' + i] = 10 + i;
+				vals['a' + i] = 10 + i;
+			}
+		}
+	};
+	constexpr NibbleTable nibbles;
+
+	[[noreturn]] void throwError(size_t line, const char* msg) {
+		throw std::runtime_error(StringUtils::format("line %" CU_PRIuSIZE ": %s", line, msg));
+	}
+
+	// decodes num hex pairs from str into out, returns the sum of the decoded bytes
+	uint8_t decodePairs(const char* str, uint8_t* out, size_t num, size_t line) {
+		uint8_t sum = 0;
+		uint8_t invalid = 0;
+		for (size_t i = 0; i < num; i++) {
+			const uint8_t hi = nibbles.vals[(uint8_t)str[i*2]];
+			const uint8_t lo = nibbles.vals[(uint8_t)str[i*2 + 1]];
+			invalid |= hi | lo;
+			const uint8_t val = (hi << 4) | (lo & 0xF);
+			out[i] = val;
+			sum += val;
+		}
+		if (invalid & 0xF0)
+			throwError(line, "invalid hex digit");
+		return sum;
+	}
+}
+
+size_t ABB::utils::IntelHex::decode(const char* begin, const char* end, uint8_t* out, size_t outSize) {
+	size_t line = 1;
+	size_t base = 0;
+	size_t used = 0;
+
+	const char* ptr = begin;
+	while (ptr < end) {
+		const char c = *ptr;
+		if (c == '\n') {
+			line++;
+			ptr++;
+			continue;
+		}
+		if (c == '\r' || c == ' ' || c == '\t') {
+			ptr++;
+			continue;
+		}
+		if (c != ':')
+			throwError(line, "expected ':' at the start of a record");
+		ptr++;
+
+		// header: byte count, address (2), record type
+		if (end - ptr < 4 * 2)
+			throwError(line, "record is truncated");
+		uint8_t header[4];
+		uint8_t sum = decodePairs(ptr, header, 4, line);
+		ptr += 4 * 2;
+
+		const size_t len = header[0];
+		const size_t addr = ((size_t)header[1] << 8) | header[2];
+		const uint8_t type = header[3];
+		if ((size_t)(end - ptr) < (len + 1) * 2)
+			throwError(line, "record is truncated");
+
+		uint8_t buf[256];
+		if (type == 0x00) {
+			const size_t dest = base + addr;
+			if (dest + len > outSize)
+				throwError(line, StringUtils::format("data at 0x%" CU_PRIxSIZE " doesn't fit into 0x%" CU_PRIxSIZE " bytes", dest + len, outSize).c_str());
+			sum += decodePairs(ptr, out + dest, len, line);
+			if (len > 0)
+				used = std::max(used, dest + len);
+		}
+		else {
+			sum += decodePairs(ptr, buf, len, line);
+		}
+		ptr += len * 2;
+
+		uint8_t checksum;
+		sum += decodePairs(ptr, &checksum, 1, line);
+		ptr += 2;
+		if (sum != 0)
+			throwError(line, "checksum mismatch");
+
+		switch (type) {
+			case 0x00:
+				break;
+			case 0x01:
+				return used;
+			case 0x02:
+				if (len != 2)
+					throwError(line, "extended segment address record needs 2 bytes");
+				base = (((size_t)buf[0] << 8) | buf[1]) << 4;
+				break;
+			case 0x04:
+				if (len != 2)
+					throwError(line, "extended linear address record needs 2 bytes");
+				base = (((size_t)buf[0] << 8) | buf[1]) << 16;
+				break;
+			case 0x03:
+			case 0x05:
+				break;
+			default:
+				throwError(line, StringUtils::format("unknown record type %02x", type).c_str());
+		}
+	}
+
+	// a missing end of file record is tolerated, everything up to here was valid
+	return used;
+}
+
+size_t ABB::utils::IntelHex::decodeFile(const char* path, uint8_t* out, size_t outSize) {
+	MappedFile file(path);
+	return decode(file.data(), file.data() + file.size(), out, outSize);
+}
+
+std::vector<ABB::utils::IntelHex::LoadedFile> ABB::utils::IntelHex::loadFiles(const std::vector<std::string>& paths, size_t maxSize) {
+	std::vector<LoadedFile> res(paths.size());
+
+	std::atomic<size_t> next(0);
+	auto work = [&] {
+		std::vector<uint8_t> buf(maxSize);
+		while (true) {
+			const size_t i = next.fetch_add(1);
+			if (i >= paths.size())
+				break;
+
+			LoadedFile& file = res[i];
+			file.path = paths[i];
+			std::fill(buf.begin(), buf.end(), 0);
+			try {
+				const size_t used = decodeFile(paths[i].c_str(), buf.data(), buf.size());
+				file.data.assign(buf.begin(), buf.begin() + used);
+			}
+			catch (const std::runtime_error& e) {
+				file.error = e.what();
+			}
+		}
+	};
+
+#ifdef __EMSCRIPTEN__
+	work();
+#else
+	const size_t numThreads = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1u), paths.size());
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < numThreads; i++)
+		threads.emplace_back(work);
+	work();
+	for (auto& thread : threads)
+		thread.join();
+#endif
+
+	return res;
+}
+
+std::vector<ABB::utils::IntelHex::LoadedFile> ABB::utils::IntelHex::loadDirectory(const char* path, size_t maxSize) {
+	std::vector<std::string> paths;
+	try {
+		for (const auto& entry : std::filesystem::directory_iterator(path)) {
+			if (!entry.is_regular_file())
+				continue;
+			const std::string filePath = entry.path().string();
+			if (std::strcmp(StringUtils::getFileExtension(filePath.c_str()), "hex") == 0)
+				paths.push_back(filePath);
+		}
+	}
+	catch (const std::filesystem::filesystem_error& e) {
+		throw std::runtime_error(StringUtils::format("Could not read directory %s: %s", path, e.what()));
+	}
+	std::sort(paths.begin(), paths.end());
+
+	return loadFiles(paths, maxSize);
+}
@@ -0,0 +1,38 @@
+#ifndef __ABB_UTILS_HEXLOADER_H__
+#define __ABB_UTILS_HEXLOADER_H__
+
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+namespace ABB {
+	namespace utils {
+		/*
+			Intel HEX decoding in a single pass over the text, straight into a caller provided buffer (no intermediate string or vector).
+			Hex pairs are decoded through a lookup table and the checksum of every record gets validated.
+			Supported record types: 00 (data), 01 (end of file), 02 (extended segment address), 04 (extended linear address),
+			03/05 (start address) are accepted and ignored.
+		*/
+		namespace IntelHex {
+			/*
+				Decodes [begin, end) into out, bytes not covered by any record are left untouched.
+				Returns one after the highest address written.
+				Throws std::runtime_error (with the line number) on malformed records, bad checksums or data beyond outSize,
+				out may be partially written in that case.
+			*/
+			size_t decode(const char* begin, const char* end, uint8_t* out, size_t outSize);
+			size_t decodeFile(const char* path, uint8_t* out, size_t outSize); // file gets memory mapped, also throws if it cant be opened
+
+			struct LoadedFile {
+				std::string path;
+				std::vector<uint8_t> data; // sized to the highest address written, gaps are 0
+				std::string error; // empty if it worked
+			};
+			// decodes all files on multiple threads (one after another on emscripten), results are in the order of paths
+			std::vector<LoadedFile> loadFiles(const std::vector<std::string>& paths, size_t maxSize);
+			std::vector<LoadedFile> loadDirectory(const char* path, size_t maxSize); // all .hex files in the directory, sorted by path
+		}
+	}
+}
+
+#endif
@@ -4,6 +4,7 @@
 #include <string>
 #include <cinttypes>
 #include <algorithm>
+#include <array>
 
 #include "../backends/SymbolBackend.h"
 
@@ -18,10 +19,49 @@ ABB::utils::HexViewer::SyntaxColors ABB::utils::HexViewer::syntaxColors;
 const ABB::utils::HexViewer::SyntaxColors ABB::utils::HexViewer::defSyntaxColors;
 ABB::utils::HexViewer::Settings ABB::utils::HexViewer::settings;
 
-ABB::utils::HexViewer::HexViewer(size_t size, uint8_t dataType) : dataType(dataType), readViz(size, 0), writeViz(size, 0) {
+ABB::utils::HexViewer::HexViewer(size_t size, uint8_t dataType) : dataType(dataType), readViz(size, 0), writeViz(size, 0), vizFrames(size, 0) {
 
 }
 
+float ABB::utils::HexViewer::getVizDecay(uint32_t frames) {
+	static const std::array<float, vizDecayTableSize> table = [] {
+		std::array<float, vizDecayTableSize> t;
+		for (size_t i = 0; i < t.size(); i++)
+			t[i] = (float)std::pow(0.99, (double)i);
+		return t;
+	}();
+	return frames < vizDecayTableSize ? table[frames] : 0;
+}
+void ABB::utils::HexViewer::accumulateViz(const uint64_t* newReads, const uint64_t* newWrites) {
+	// most bytes dont get accessed in a frame, so we first check whole blocks (which vectorizes nicely) and only update the ones with accesses
+	constexpr size_t blockSize = 16;
+	const size_t len = readViz.size();
+	for (size_t blockStart = 0; blockStart < len; blockStart += blockSize) {
+		const size_t blockEnd = std::min(blockStart + blockSize, len);
+
+		uint64_t any = 0;
+		for (size_t i = blockStart; i < blockEnd; i++)
+			any |= (newReads ? newReads[i] : 0) | (newWrites ? newWrites[i] : 0);
+		if (any == 0)
+			continue;
+
+		for (size_t i = blockStart; i < blockEnd; i++) {
+			const uint64_t r = newReads ? newReads[i] : 0;
+			const uint64_t w = newWrites ? newWrites[i] : 0;
+			if ((r | w) == 0)
+				continue;
+
+			const float decay = getVizDecay(vizFrame - vizFrames[i]);
+			readViz[i] = readViz[i] * decay + r;
+			writeViz[i] = writeViz[i] * decay + w;
+			vizFrames[i] = vizFrame;
+		}
+	}
+}
+float ABB::utils::HexViewer::getViz(size_t addr) const {
+	return std::max(readViz[addr], writeViz[addr]) * getVizDecay(vizFrame - vizFrames[addr]);
+}
+
 bool ABB::utils::HexViewer::isSelected(size_t addr) const {
 	return addr >= selectStart && addr < selectEnd;
 }
@@ -29,12 +69,19 @@ void ABB::utils::HexViewer::setEditCallback(DataUtils::EditMemory::SetValueCallB
 	eb.setEditCallB(func, userData);
 }
 
-ImRect ABB::utils::HexViewer::getNextByteRect(const ImVec2& charSize) const {
-	ImVec2 cursorScreenPos = ImGui::GetCursorScreenPos();
-	return ImRect(
-		{ cursorScreenPos.x + charSize.x , cursorScreenPos.y },
-		{ cursorScreenPos.x + charSize.x * 3, cursorScreenPos.y + charSize.y }
-	);
+const char* ABB::utils::HexViewer::getHexPairs(bool upperCase) {
+	static const std::array<char, 2*256*2> table = [] {
+		std::array<char, 2*256*2> t;
+		const char* digits[2] = { "0123456789abcdef", "0123456789ABCDEF" };
+		for (size_t c = 0; c < 2; c++) {
+			for (size_t i = 0; i < 256; i++) {
+				t[c*512 + i*2]     = digits[c][i >> 4];
+				t[c*512 + i*2 + 1] = digits[c][i & 0xf];
+			}
+		}
+		return t;
+	}();
+	return table.data() + (upperCase ? 512 : 0);
 }
 
 size_t ABB::utils::HexViewer::getBytesPerRow(float widthAvail, const ImVec2& charSize) {
@@ -83,22 +130,10 @@ void ABB::utils::HexViewer::drawHoverInfo(size_t addr, const EmuUtils::SymbolTab
 		SymbolBackend::drawSymbol(symbol, addr, data);
 }
 
-void ABB::utils::HexViewer::draw(const uint8_t* data, size_t dataLen, const EmuUtils::SymbolTable* symbolTable, const EmuUtils::SymbolTable::SymbolList* symbolList, const uint64_t* newReads, const uint64_t* newWrites) {
-	for (size_t i = 0; i < readViz.size(); i++)
-		readViz[i] *= 0.99f;
-	for (size_t i = 0; i < writeViz.size(); i++)
-		writeViz[i] *= 0.99f;
-
-	if (newReads) {
-		for (size_t i = 0; i < readViz.size(); i++) {
-			readViz[i] += newReads[i];
-		}
-	}
-	if (newWrites) {
-		for (size_t i = 0; i < writeViz.size(); i++) {
-			writeViz[i] += newWrites[i];
-		}
-	}
+void ABB::utils::HexViewer::draw(const uint8_t* data, size_t dataLen, const EmuUtils::SymbolTable* symbolTable, const EmuUtils::SymbolTable::SymbolList* symbolList, const SymbolIndex::Intervals* symbolIntervals, const uint64_t* newReads, const uint64_t* newWrites) {
+	vizFrame++;
+	if (settings.showRWViz && (newReads || newWrites))
+		accumulateViz(newReads, newWrites);
 
 
 	if (!ImGui::IsPopupOpen("symbolHoverInfoPopup"))
@@ -137,16 +172,41 @@ void ABB::utils::HexViewer::draw(const uint8_t* data, size_t dataLen, const EmuU
 
 	int32_t bytesPerRow = (int32_t)getBytesPerRow(sizeAvail.x, charSize);
 	const size_t numOfRows = (size_t)std::ceil((float)dataLen / (float)bytesPerRow);
+	const size_t rowLen = (size_t)bytesPerRow;
 
 	size_t currHoveredAddr = -1;
 
 	ImDrawList* drawList = ImGui::GetWindowDrawList();
-	//const ImVec4 defTexCol = ImGui::GetStyleColorVec4(ImGuiCol_Text);
+	ImFont* font = ImGui::GetFont();
+	const float fontSize = ImGui::GetFontSize();
 	ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(0, settings.vertSpacing));
 
 
-	EmuUtils::SymbolTable::SymbolFeeder feeder(symbolTable,symbolList);
+	SymbolIndex::Intervals::Cursor symbolCursor(symbolIntervals);
+
+	// layout of a row (in chars): "addr:", " xx" per byte, "  " + one char per byte (ascii), " " + byte textures
+	constexpr size_t hexStart = AddrDigits + 1;
+	const size_t asciiStart = hexStart + 3 * rowLen + 2;
+	const size_t textEnd = settings.showAscii ? asciiStart + rowLen : hexStart + 3 * rowLen;
+	const float texStartX = (textEnd + 1) * charSize.x;
+	const float texByteWidth = charSize.y / 8;
+	const float rowWidth = settings.showTex ? texStartX + texByteWidth * rowLen : textEnd * charSize.x;
 
+	const char* hexPairs = getHexPairs(settings.upperCaseHex);
+	const ImU32 addrCol = ImColor(syntaxColors.Addr);
+	const ImU32 bytesCol = ImColor(syntaxColors.bytes);
+	const ImU32 asciiCol = ImColor(syntaxColors.ascii);
+	const ImU32 textCol = ImGui::GetColorU32(ImGuiCol_Text);
+
+	struct Run {
+		size_t start;
+		size_t end;
+		ImU32 textCol;
+	};
+	std::vector<char> rowBuf(asciiStart + rowLen); // whole row preformatted
+	std::vector<const EmuUtils::SymbolTable::Symbol*> rowSymbols(rowLen, nullptr);
+	std::vector<Run> runs; // runs of bytes with the same symbol
+	runs.reserve(rowLen);
 
 	ImGuiListClipper clipper;
 	clipper.Begin((int)numOfRows);
@@ -154,195 +214,164 @@ void ABB::utils::HexViewer::draw(const uint8_t* data, size_t dataLen, const EmuU
 
 	while (clipper.Step()) {
 		for (int line_no = clipper.DisplayStart; line_no < clipper.DisplayEnd; line_no++) {
-			size_t lineAddr = line_no * bytesPerRow;
-			char addrBuf[AddrDigits];
-			StringUtils::uIntToHexBufCase(lineAddr, addrBuf, settings.upperCaseHex, AddrDigits);
-			ImGuiExt::TextColored(syntaxColors.Addr, addrBuf, addrBuf+4);
-			ImGui::SameLine();
-			ImGui::TextUnformatted(":");
+			const size_t lineAddr = line_no * rowLen;
 
-			size_t numOfItemsInRow = bytesPerRow;
-			bool fillUp = false;
+			size_t numOfItemsInRow = rowLen;
 			if ((size_t)line_no == numOfRows - 1) { // if is last line
-				numOfItemsInRow = dataLen % bytesPerRow;
-				if (numOfItemsInRow == 0) {
-					numOfItemsInRow = bytesPerRow;
-				}
-				else {
-					fillUp = true;
-				}
+				numOfItemsInRow = dataLen % rowLen;
+				if (numOfItemsInRow == 0)
+					numOfItemsInRow = rowLen;
 			}
-			
-			// bytes
-			ImGuiExt::PushTextColor(syntaxColors.bytes);
-			for (size_t i = 0; i < numOfItemsInRow; i++) {
-				const size_t addrOff = lineAddr + i;
-				const uint8_t byte = *(data + addrOff);
-				ImGui::SameLine();
 
-				const ImRect nextItemRect = getNextByteRect(charSize);
+			// the whole row is one item, the byte under the mouse is found by its position
+			const ImVec2 rowPos = ImGui::GetCursorScreenPos();
+			ImGui::Dummy({ rowWidth, charSize.y });
+			const bool rowHovered = ImGui::IsItemHovered();
+			auto charX = [&](size_t c) {
+				return rowPos.x + c * charSize.x;
+			};
+
+			char* buf = rowBuf.data();
+			StringUtils::uIntToHexBufCase(lineAddr, buf, settings.upperCaseHex, AddrDigits);
+			buf[AddrDigits] = ':';
+			for (size_t i = 0; i < numOfItemsInRow; i++) {
+				const uint8_t byte = data[lineAddr + i];
+				char* b = buf + hexStart + i * 3;
+				b[0] = ' ';
+				b[1] = hexPairs[byte * 2];
+				b[2] = hexPairs[byte * 2 + 1];
+			}
+			if (settings.showAscii) {
+				for (size_t i = 0; i < numOfItemsInRow; i++) {
+					const char c = (char)data[lineAddr + i];
+					buf[asciiStart + i] = isprint((unsigned char)c) ? c : '.';
+				}
+			}
 
-				if (settings.showRWViz) {
-					float val = std::max(readViz[addrOff], writeViz[addrOff]);
-					float bright = std::log(val)*0.2f;
+			if (settings.showRWViz) {
+				for (size_t i = 0; i < numOfItemsInRow; i++) {
+					float bright = std::log(getViz(lineAddr + i))*0.2f;
 					if (bright > 1)
 						bright = 1;
 
 					if (bright > 0.05)
-						drawList->AddRectFilled(nextItemRect.Min, nextItemRect.Max, ImColor(ImVec4(bright, bright, bright, 1)));
+						drawList->AddRectFilled({ charX(hexStart + i * 3 + 1), rowPos.y }, { charX(hexStart + i * 3 + 3), rowPos.y + charSize.y }, ImColor(ImVec4(bright, bright, bright, 1)));
 				}
+			}
 
-				const EmuUtils::SymbolTable::Symbol* symbol = nullptr;
-				if (settings.showSymbols) {
-					symbol = feeder.getSymbol(addrOff);
-					if (symbol) {
-						ImVec2 min = nextItemRect.Min, max = nextItemRect.Max;
-
-						if(i != 0) // check if not first item in row
-							if (addrOff == symbol->value)
-								min.x -= charSize.x / 2;
-
-						if (i != numOfItemsInRow - 1) { // check if not last item in row
-							max.x += charSize.x; // make rect wider to include the ' '
-							if (addrOff + 1 == symbol->value + symbol->size)
-								max.x -= charSize.x / 2;
-						}
-
-						//if (nextSymbolAddrEnd > (lineAddr + bytesPerRow))
-							max.y += settings.vertSpacing;
-						
-						if(!settings.showRWViz)
-							drawList->AddRectFilled( min, max, ImColor(SymbolBackend::getSymbolColor(symbol->id)) );
-						else
-							drawList->AddRect( min, max, ImColor(SymbolBackend::getSymbolColor(symbol->id)), 0, 0, 2);
+			// symbols: one rect per run of bytes belonging to the same symbol
+			runs.clear();
+			for (size_t i = 0; i < numOfItemsInRow; i++)
+				rowSymbols[i] = settings.showSymbols ? symbolCursor.getSymbol(lineAddr + i) : nullptr;
+			for (size_t runStart = 0; runStart < numOfItemsInRow; ) {
+				const EmuUtils::SymbolTable::Symbol* symbol = rowSymbols[runStart];
+				size_t runEnd = runStart + 1;
+				while (runEnd < numOfItemsInRow && rowSymbols[runEnd] == symbol)
+					runEnd++;
+
+				ImU32 runTextCol = bytesCol;
+				if (symbol) {
+					const ImVec4 col = SymbolBackend::getSymbolColor(symbol->id);
+					ImVec2 min = { charX(hexStart + runStart * 3 + 1), rowPos.y };
+					ImVec2 max = { charX(hexStart + runEnd * 3), rowPos.y + charSize.y + settings.vertSpacing };
+
+					if (runStart != 0 && lineAddr + runStart == symbol->value) // check if not first item in row
+						min.x -= charSize.x / 2;
+
+					if (runEnd != numOfItemsInRow) { // check if not last item in row
+						max.x += charSize.x; // make rect wider to include the ' '
+						if (lineAddr + runEnd == symbol->value + symbol->size)
+							max.x -= charSize.x / 2;
 					}
-				}
 
-				// highlight address stack indicators (indicators that bytes in ram are addresses pushed onto stack by instructions e.g. "call")
-				/*
-				if (dataType == DataType_Ram && symbolTable != nullptr && addrOff >= A32u4::DataSpace::Consts::ISRAM_start && mcu->debugger.getAddressStackIndicators()[addrOff - A32u4::DataSpace::Consts::ISRAM_start]) {
-					uint8_t val = mcu->debugger.getAddressStackIndicators()[addrOff - A32u4::DataSpace::Consts::ISRAM_start];
-					ImVec2 min = nextItemRect.Min, max = nextItemRect.Max;
-					if (val == 1)
-						min.x -= charSize.x/2;
-					if (val == 2)
-						max.x += charSize.x/2;
-					drawList->AddRectFilled( min, max, IM_COL32(0,255,50,70) );
-				}
-				*/
+					if(!settings.showRWViz)
+						drawList->AddRectFilled(min, max, ImColor(col));
+					else
+						drawList->AddRect(min, max, ImColor(col), 0, 0, 2);
 
-				if (isSelected(addrOff)) {
-					ImRect nextItemRect = getNextByteRect(charSize);
-					drawList->AddRectFilled( nextItemRect.Min, nextItemRect.Max,IM_COL32(50, 50, 255, 100) );
+					runTextCol = settings.invertTextColOverSymbols ? (ImU32)ImColor(ImVec4{ 1 - col.x, 1 - col.y, 1 - col.z, 1 }) : IM_COL32_BLACK;
 				}
+				runs.push_back(Run{ runStart, runEnd, runTextCol });
+				runStart = runEnd;
+			}
 
-				char byteStr[3];
-				byteStr[0] = ' ';
-				StringUtils::uIntToHexBufCase(byte, byteStr + 1, settings.upperCaseHex, 2);
-				if (!symbol) {
-					ImGui::TextUnformatted(byteStr, byteStr + 3);
-				}
-				else {
-					if (settings.invertTextColOverSymbols) {
-						ImVec4 col = SymbolBackend::getSymbolColor(symbol->id);
-						ImGuiExt::TextColored({ 1 - col.x, 1 - col.y, 1 - col.z, 1 }, byteStr, byteStr + 3);
-					} else {
-						ImGuiExt::TextColored({0, 0, 0, 1}, byteStr, byteStr + 3);
-					}
+			{
+				const size_t selFrom = std::max(selectStart, lineAddr);
+				const size_t selTo = std::min(selectEnd, lineAddr + numOfItemsInRow);
+				for (size_t addr = selFrom; addr < selTo; addr++) {
+					const size_t i = addr - lineAddr;
+					drawList->AddRectFilled({ charX(hexStart + i * 3 + 1), rowPos.y }, { charX(hexStart + i * 3 + 3), rowPos.y + charSize.y }, IM_COL32(50, 50, 255, 100));
 				}
-					
-				/*
-				if (mcu != nullptr && mcu->cpu.getPCAddr() == addrOff) {
-					drawList->AddRect( nextItemRect.Min, nextItemRect.Max, IM_COL32(255,0,0,255) );
-				}
-				*/
+			}
+			if (settings.showAscii && hoveredAddr >= lineAddr && hoveredAddr < lineAddr + numOfItemsInRow) {
+				const float x = charX(asciiStart + hoveredAddr - lineAddr);
+				drawList->AddRectFilled({ x, rowPos.y }, { x + charSize.x, rowPos.y + charSize.y }, ImColor(ImVec4{0.1f,0.1f,0.5f,1}));
+			}
+
+			// text, one call per color span
+			drawList->AddText(font, fontSize, rowPos, addrCol, buf, buf + AddrDigits);
+			drawList->AddText(font, fontSize, { charX(AddrDigits), rowPos.y }, textCol, buf + AddrDigits, buf + hexStart);
+			for (size_t r = 0; r < runs.size(); ) {
+				size_t spanEnd = r + 1;
+				while (spanEnd < runs.size() && runs[spanEnd].textCol == runs[r].textCol)
+					spanEnd++;
+
+				const size_t start = runs[r].start, end = runs[spanEnd - 1].end;
+				drawList->AddText(font, fontSize, { charX(hexStart + start * 3), rowPos.y }, runs[r].textCol, buf + hexStart + start * 3, buf + hexStart + end * 3);
+				r = spanEnd;
+			}
+			if (settings.showAscii)
+				drawList->AddText(font, fontSize, { charX(asciiStart), rowPos.y }, asciiCol, buf + asciiStart, buf + asciiStart + numOfItemsInRow);
+
+			if (settings.showTex)
+				ByteVisualiser::DrawBytes(drawList, { rowPos.x + texStartX, rowPos.y }, data + lineAddr, numOfItemsInRow, texByteWidth, charSize.y);
 
-				if (ImGui::IsItemClicked(ImGuiMouseButton_Left) && ImGui::GetIO().KeyShift) {
-						isSelecting = true;
-						selectStart = addrOff;
-						selectEnd = addrOff + 1;
+			if (!rowHovered)
+				continue;
+
+			const float mouseChar = (ImGui::GetIO().MousePos.x - rowPos.x) / charSize.x;
+			if (mouseChar >= hexStart && mouseChar < hexStart + numOfItemsInRow * 3) {
+				const size_t i = (size_t)(mouseChar - hexStart) / 3;
+				const size_t addrOff = lineAddr + i;
+				const EmuUtils::SymbolTable::Symbol* symbol = rowSymbols[i];
+				const bool clickedLeft = ImGui::IsMouseClicked(ImGuiMouseButton_Left);
+
+				if (clickedLeft && ImGui::GetIO().KeyShift) {
+					isSelecting = true;
+					selectStart = addrOff;
+					selectEnd = addrOff + 1;
 				}
-				else if (ImGui::IsItemClicked(ImGuiMouseButton_Right)) {
+				else if (ImGui::IsMouseClicked(ImGuiMouseButton_Right)) {
 					if (eb.canEdit()) {
 						eb.openEditPopup(data, dataLen, (Console::addrmcu_t)addrOff);
 					}
 				}
 
-				if (ImGui::IsItemHovered()) {
-					if (isSelecting) {
-						selectEnd = addrOff + 1;
-					}
-					else {
-						currHoveredAddr = hoveredAddr = addrOff;
-
-						if (symbol && ImGui::IsItemClicked(ImGuiMouseButton_Left) && !ImGui::GetIO().KeyShift) {
-							ImGui::OpenPopup("symbolHoverInfoPopup");
-							
-							popupSymbol = symbol;
-							popupAddr = addrOff;
-						}
-						else {
-							ImGui::BeginTooltip();
-							ImGui::PopStyleVar();
-							ImGuiExt::PopTextColor();
-
-							drawHoverInfo(addrOff, symbol, data);
-
-							ImGuiExt::PushTextColor(syntaxColors.bytes);
-							ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(0, settings.vertSpacing));
-							ImGui::EndTooltip();
-						}
-					}
+				if (isSelecting) {
+					selectEnd = addrOff + 1;
 				}
-			}
-			ImGuiExt::PopTextColor();
+				else {
+					currHoveredAddr = hoveredAddr = addrOff;
 
-			if (fillUp) {
-				ImGui::SameLine();
-				ImGui::TextUnformatted(std::string(3 * (bytesPerRow - numOfItemsInRow), ' ').c_str());
-			}
+					if (symbol && clickedLeft && !ImGui::GetIO().KeyShift) {
+						ImGui::OpenPopup("symbolHoverInfoPopup");
 
+						popupSymbol = symbol;
+						popupAddr = addrOff;
+					}
+					else {
+						ImGui::BeginTooltip();
+						ImGui::PopStyleVar();
 
-			// ascii
-			ImGuiExt::PushTextColor(syntaxColors.ascii);
-			if (settings.showAscii) {
-				ImGui::SameLine();
-				ImGui::TextUnformatted("  ");
-				for (size_t i = 0; i < numOfItemsInRow; i++) {
-					const size_t addrOff = lineAddr + i;
-					
-					char c = *(data + addrOff);
-					if (!isprint((unsigned char)c))
-						c = '.';
-
-					ImGui::SameLine();
-					if (addrOff == hoveredAddr)
-						drawList->AddRectFilled(
-							ImGui::GetCursorScreenPos(),
-							{ ImGui::GetCursorScreenPos().x + charSize.x, ImGui::GetCursorScreenPos().y + charSize.y },
-							ImColor(ImVec4{0.1f,0.1f,0.5f,1})
-						);
-					ImGui::TextUnformatted(&c, &c + 1);
-					if (ImGui::IsItemHovered())
-						currHoveredAddr = addrOff;
+						drawHoverInfo(addrOff, symbol, data);
+
+						ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(0, settings.vertSpacing));
+						ImGui::EndTooltip();
+					}
 				}
 			}
-			if (fillUp) {
-				ImGui::SameLine();
-				ImGui::TextUnformatted(std::string(bytesPerRow - numOfItemsInRow, ' ').c_str());
-			}
-			ImGuiExt::PopTextColor();
-			
-			// byte viz
-			if (settings.showTex) {
-				ImGui::SameLine();
-				ImGui::TextUnformatted(" ");
-				for (size_t i = 0; i < numOfItemsInRow; i++) {
-					const size_t addrOff = lineAddr + i;
-					uint8_t byte = *(data + addrOff);
-					ImGui::SameLine();
-					ByteVisualiser::DrawByte(byte,charSize.y / 8, charSize.y);
-				}
+			else if (settings.showAscii && mouseChar >= asciiStart && mouseChar < asciiStart + numOfItemsInRow) {
+				currHoveredAddr = lineAddr + (size_t)(mouseChar - asciiStart);
 			}
 		}
 	}
@@ -665,6 +694,8 @@ size_t ABB::utils::HexViewer::sizeBytes() const {
 
 	sum += DataUtils::approxSizeOf(readViz);
 	sum += DataUtils::approxSizeOf(writeViz);
+	sum += DataUtils::approxSizeOf(vizFrames);
+	sum += sizeof(vizFrame);
 
 	return sum;
 }
@@ -13,6 +13,7 @@
 
 #include "../Console.h"
 #include "SymbolTable.h"
+#include "symbolIndex.h"
 
 #include "DataUtils.h"
 
@@ -109,10 +110,18 @@ namespace ABB {
 
 			EditBytes eb;
 
-			std::vector<float> readViz;
+			// read/write visualization: values decay by 0.99 per frame, but only get updated when new accesses happen or when they get drawn
+			std::vector<float> readViz; // values at vizFrames
 			std::vector<float> writeViz;
+			std::vector<uint32_t> vizFrames; // [addr] = frame at which readViz/writeViz of addr were last updated
+			uint32_t vizFrame = 0; // current frame
 
-			ImRect getNextByteRect(const ImVec2& charSize) const;
+			static constexpr size_t vizDecayTableSize = 2048; // 0.99^2048 is small enough to count as nothing
+			static float getVizDecay(uint32_t frames); // 0.99^frames
+			void accumulateViz(const uint64_t* newReads, const uint64_t* newWrites);
+			float getViz(size_t addr) const;
+
+			static const char* getHexPairs(bool upperCase); // 256 two char hex strings, one for every byte value
 			size_t getBytesPerRow(float widthAvail, const ImVec2& charSize);
 
 			void drawHoverInfo(size_t addr, const EmuUtils::SymbolTable::Symbol* symbol, const uint8_t* data);
@@ -124,7 +133,7 @@ namespace ABB {
 
 			bool isSelected(size_t addr) const;
 
-			void draw(const uint8_t* data, size_t dataLen, const EmuUtils::SymbolTable* symbolTable = nullptr, const EmuUtils::SymbolTable::SymbolList* symbolList = nullptr, const uint64_t* newReads = nullptr, const uint64_t* newWrites = nullptr);
+			void draw(const uint8_t* data, size_t dataLen, const EmuUtils::SymbolTable* symbolTable = nullptr, const EmuUtils::SymbolTable::SymbolList* symbolList = nullptr, const SymbolIndex::Intervals* symbolIntervals = nullptr, const uint64_t* newReads = nullptr, const uint64_t* newWrites = nullptr);
 
 			void setEditCallback(DataUtils::EditMemory::SetValueCallB func, void* userData);
 
@@ -0,0 +1,96 @@
+#include "logQueue.h"
+
+ABB::utils::LogQueue::LogQueue(size_t capacity) : pushPos(0), dropped(0) {
+	init(capacity);
+}
+ABB::utils::LogQueue::LogQueue(const LogQueue& src) : pushPos(0), dropped(0) {
+	init(src.capacity());
+}
+ABB::utils::LogQueue& ABB::utils::LogQueue::operator=(const LogQueue& src) {
+	if (this != &src) {
+		pushPos.store(0);
+		popPos = 0;
+		dropped.store(0);
+		init(src.capacity());
+	}
+	return *this;
+}
+
+void ABB::utils::LogQueue::init(size_t capacity_) {
+	size_t capacity = 2;
+	while (capacity < capacity_)
+		capacity *= 2;
+
+	slots = std::unique_ptr<Slot[]>(new Slot[capacity]);
+	mask = capacity - 1;
+	for (size_t i = 0; i < capacity; i++) {
+		slots[i].seq.store(i, std::memory_order_relaxed);
+		slots[i].msg.msg.reserve(msgReserve);
+		slots[i].msg.module.reserve(32);
+		slots[i].msg.fileName.reserve(msgReserve);
+	}
+}
+
+bool ABB::utils::LogQueue::push(uint8_t level, const char* msg, const char* fileName, int lineNum, const char* module) {
+	// slot i is free for the push at position pos if its seq == pos, and holds a message for the pop at pos if seq == pos+1
+	size_t pos = pushPos.load(std::memory_order_relaxed);
+	Slot* slot;
+	while (true) {
+		slot = &slots[pos & mask];
+		const size_t seq = slot->seq.load(std::memory_order_acquire);
+		const intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+		if (diff == 0) {
+			if (pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (diff < 0) {
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		else {
+			pos = pushPos.load(std::memory_order_relaxed);
+		}
+	}
+
+	Msg& m = slot->msg;
+	m.level = level;
+	m.lineNum = lineNum;
+	m.msg.assign(msg ? msg : "");
+	m.module.assign(module ? module : "");
+	m.fileName.assign(fileName ? fileName : "");
+
+	slot->seq.store(pos + 1, std::memory_order_release);
+	return true;
+}
+
+const ABB::utils::LogQueue::Msg* ABB::utils::LogQueue::front() const {
+	const Slot& slot = slots[popPos & mask];
+	if (slot.seq.load(std::memory_order_acquire) != popPos + 1)
+		return nullptr;
+	return &slot.msg;
+}
+void ABB::utils::LogQueue::pop() {
+	Slot& slot = slots[popPos & mask];
+	slot.seq.store(popPos + mask + 1, std::memory_order_release);
+	popPos++;
+}
+size_t ABB::utils::LogQueue::takeDropped() {
+	return dropped.exchange(0, std::memory_order_relaxed);
+}
+
+size_t ABB::utils::LogQueue::capacity() const {
+	return mask + 1;
+}
+size_t ABB::utils::LogQueue::sizeBytes() const {
+	size_t sum = 0;
+
+	sum += sizeof(slots) + sizeof(mask);
+	for (size_t i = 0; i < capacity(); i++) {
+		const Msg& m = slots[i].msg;
+		sum += sizeof(Slot) + m.msg.capacity() + m.module.capacity() + m.fileName.capacity();
+	}
+
+	sum += sizeof(pushPos) + sizeof(popPos) + sizeof(dropped);
+
+	return sum;
+}
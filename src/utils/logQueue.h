@@ -0,0 +1,60 @@
+#ifndef __ABB_UTILS_LOGQUEUE_H__
+#define __ABB_UTILS_LOGQUEUE_H__
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <string>
+
+namespace ABB {
+	namespace utils {
+		/*
+			Bounded lock-free queue for log messages (any number of producers, one consumer).
+			All slots and their strings are allocated up front, so pushing normally doesnt allocate;
+			if the queue is full the message gets dropped and counted instead of blocking the producer.
+		*/
+		class LogQueue {
+		public:
+			struct Msg {
+				uint8_t level;
+				int lineNum;
+				std::string msg;
+				std::string module;
+				std::string fileName;
+			};
+		private:
+			struct Slot {
+				std::atomic<size_t> seq;
+				Msg msg;
+			};
+
+			std::unique_ptr<Slot[]> slots;
+			size_t mask;
+
+			std::atomic<size_t> pushPos;
+			size_t popPos = 0; // only touched by the consumer
+			std::atomic<size_t> dropped;
+
+			void init(size_t capacity);
+		public:
+			static constexpr size_t defCapacity = 4096;
+			static constexpr size_t msgReserve = 128;
+
+			LogQueue(size_t capacity = defCapacity); // capacity gets rounded up to a power of 2
+			LogQueue(const LogQueue& src); // copies only get the capacity, not the queued messages
+			LogQueue& operator=(const LogQueue& src);
+
+			bool push(uint8_t level, const char* msg, const char* fileName, int lineNum, const char* module); // false if it was full
+
+			// consumer only
+			const Msg* front() const; // nullptr if empty
+			void pop();
+			size_t takeDropped(); // number of messages dropped since the last call
+
+			size_t capacity() const;
+			size_t sizeBytes() const;
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,259 @@
+#include "logStore.h"
+
+#include <cstring>
+#include <algorithm>
+
+#include "DataUtils.h"
+#include "DataUtilsSize.h"
+
+ABB::utils::LogStore::Chunk::Chunk(size_t size, size_t firstEntry) : data(new char[size]), size(size), firstEntry(firstEntry) {
+
+}
+
+ABB::utils::LogStore::LogStore(size_t maxEntries) : maxEntries(maxEntries), names({ "" }) {
+	nameIds[""] = 0;
+}
+
+ABB::utils::LogStore::LogStore(const LogStore& src) : maxEntries(0) {
+	*this = src;
+}
+ABB::utils::LogStore& ABB::utils::LogStore::operator=(const LogStore& src) {
+	if (this == &src)
+		return *this;
+
+	maxEntries = src.maxEntries;
+	names = src.names;
+	nameIds = src.nameIds;
+	namePtrIds = src.namePtrIds;
+	levelInds = src.levelInds;
+
+	entries.clear();
+	chunks.clear();
+	entriesBegin = src.entriesBegin;
+	for (const Entry& entry : src.entries) {
+		entries.push_back(entry);
+		entries.back().msg = storeMsg(entry.msg, entry.msgLen, end() - 1);
+	}
+	return *this;
+}
+
+const char* ABB::utils::LogStore::storeMsg(const char* msg, size_t msgLen, size_t ind) {
+	if (chunks.size() == 0 || chunks.back()->size - chunks.back()->used < msgLen + 1)
+		chunks.push_back(std::make_shared<Chunk>(std::max(defChunkSize, msgLen + 1), ind));
+
+	Chunk& chunk = *chunks.back();
+	char* dest = chunk.data.get() + chunk.used;
+	std::memcpy(dest, msg, msgLen);
+	dest[msgLen] = 0;
+	chunk.used += msgLen + 1;
+	return dest;
+}
+
+size_t ABB::utils::LogStore::add(uint8_t level, const char* msg, size_t msgLen, const char* module, const char* fileName, int lineNum, size_t id) {
+	const size_t ind = end();
+
+	const char* dest = storeMsg(msg, msgLen, ind);
+	entries.push_back(Entry{ dest, (uint32_t)msgLen, level, intern(module), intern(fileName), lineNum, 1, id });
+	if (level >= levelInds.size())
+		levelInds.resize(level + 1);
+	levelInds[level].push_back(ind);
+
+	evict();
+	return ind;
+}
+
+bool ABB::utils::LogStore::repeatLast(uint8_t level, const char* msg, size_t msgLen, const char* module, const char* fileName, int lineNum) {
+	if (entries.size() == 0)
+		return false;
+
+	Entry& last = entries.back();
+	if (last.level != level || last.lineNum != lineNum || last.msgLen != msgLen || std::memcmp(last.msg, msg, msgLen) != 0)
+		return false;
+	if (last.module != intern(module) || last.fileName != intern(fileName))
+		return false;
+
+	last.count++;
+	return true;
+}
+
+void ABB::utils::LogStore::evict() {
+	if (maxEntries == 0 || entries.size() <= maxEntries)
+		return;
+
+	const size_t num = entries.size() - maxEntries;
+	entries.erase(entries.begin(), entries.begin() + num);
+	entriesBegin += num;
+	for (auto& inds : levelInds) {
+		while (inds.size() > 0 && inds.front() < entriesBegin)
+			inds.pop_front();
+	}
+
+	// a chunk can go once the next one starts at or before the oldest entry
+	while (chunks.size() > 1 && chunks[1]->firstEntry <= entriesBegin)
+		chunks.pop_front();
+}
+
+void ABB::utils::LogStore::clear() {
+	entriesBegin = end();
+	entries.clear();
+	chunks.clear();
+	levelInds.clear();
+}
+
+void ABB::utils::LogStore::setMaxEntries(size_t maxEntries_) {
+	maxEntries = maxEntries_;
+	evict();
+}
+size_t ABB::utils::LogStore::getMaxEntries() const {
+	return maxEntries;
+}
+
+size_t ABB::utils::LogStore::begin() const {
+	return entriesBegin;
+}
+size_t ABB::utils::LogStore::end() const {
+	return entriesBegin + entries.size();
+}
+size_t ABB::utils::LogStore::size() const {
+	return entries.size();
+}
+bool ABB::utils::LogStore::has(size_t ind) const {
+	return ind >= begin() && ind < end();
+}
+const ABB::utils::LogStore::Entry& ABB::utils::LogStore::get(size_t ind) const {
+	DU_ASSERT(has(ind));
+	return entries[ind - entriesBegin];
+}
+const std::deque<size_t>& ABB::utils::LogStore::getLevelInds(uint8_t level) const {
+	static const std::deque<size_t> empty;
+	return level < levelInds.size() ? levelInds[level] : empty;
+}
+
+const std::deque<std::shared_ptr<ABB::utils::LogStore::Chunk>>& ABB::utils::LogStore::getChunks() const {
+	return chunks;
+}
+
+ABB::utils::LogStore::name_t ABB::utils::LogStore::intern(const char* str) {
+	if (!str || *str == 0)
+		return 0;
+
+	{
+		auto res = namePtrIds.find(str);
+		if (res != namePtrIds.end() && std::strcmp(names[res->second].c_str(), str) == 0)
+			return res->second;
+	}
+
+	auto res = nameIds.insert({ str, (name_t)names.size() });
+	if (res.second)
+		names.push_back(str);
+	namePtrIds[str] = res.first->second;
+	return res.first->second;
+}
+const std::string& ABB::utils::LogStore::getName(name_t name) const {
+	return names[name];
+}
+
+size_t ABB::utils::LogStore::sizeBytes() const {
+	size_t sum = 0;
+
+	sum += sizeof(maxEntries);
+
+	sum += entries.size() * sizeof(Entry);
+	sum += sizeof(entriesBegin);
+	for (auto& chunk : chunks)
+		sum += sizeof(Chunk) + chunk->size;
+	for (auto& inds : levelInds)
+		sum += sizeof(inds) + inds.size() * sizeof(size_t);
+
+	sum += DataUtils::approxSizeOf(names);
+	for (auto& name : names)
+		sum += DataUtils::approxSizeOf(name);
+	sum += nameIds.size() * (sizeof(std::string) + sizeof(name_t));
+	sum += namePtrIds.size() * (sizeof(const void*) + sizeof(name_t));
+
+	return sum;
+}
+
+
+size_t ABB::utils::LogStore::View::idAt(const Source& source, size_t i) const {
+	return source.store->get((*source.inds)[i]).id;
+}
+size_t ABB::utils::LogStore::View::lowerBound(const Source& source, size_t id) const {
+	size_t from = 0, to = source.inds->size();
+	while (from < to) {
+		const size_t mid = from + (to - from) / 2;
+		if (idAt(source, mid) < id)
+			from = mid + 1;
+		else
+			to = mid;
+	}
+	return from;
+}
+
+void ABB::utils::LogStore::View::clear() {
+	sources.clear();
+}
+void ABB::utils::LogStore::View::addStore(const LogStore* store, uint8_t minLevel) {
+	for (size_t level = minLevel; level < store->levelInds.size(); level++) {
+		if (store->levelInds[level].size() > 0)
+			sources.push_back(Source{ store, &store->levelInds[level] });
+	}
+}
+
+size_t ABB::utils::LogStore::View::size() const {
+	size_t sum = 0;
+	for (auto& source : sources)
+		sum += source.inds->size();
+	return sum;
+}
+size_t ABB::utils::LogStore::View::rankOf(size_t id) const {
+	size_t sum = 0;
+	for (auto& source : sources)
+		sum += lowerBound(source, id);
+	return sum;
+}
+
+void ABB::utils::LogStore::View::get(size_t from, size_t to, std::vector<Item>* out) const {
+	to = std::min(to, size());
+	if (from >= to)
+		return;
+
+	// find the id of the entry at position from: the smallest id with more than from entries at or below it
+	size_t lo = (size_t)-1, hi = 0;
+	for (auto& source : sources) {
+		if (source.inds->size() == 0)
+			continue;
+		lo = std::min(lo, idAt(source, 0));
+		hi = std::max(hi, idAt(source, source.inds->size() - 1));
+	}
+	while (lo < hi) {
+		const size_t mid = lo + (hi - lo) / 2;
+		if (rankOf(mid + 1) > from)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	// then merge from there on
+	std::vector<size_t> pos(sources.size());
+	for (size_t i = 0; i < sources.size(); i++)
+		pos[i] = lowerBound(sources[i], lo);
+
+	for (size_t n = from; n < to; n++) {
+		size_t best = (size_t)-1;
+		size_t bestId = (size_t)-1;
+		for (size_t i = 0; i < sources.size(); i++) {
+			if (pos[i] >= sources[i].inds->size())
+				continue;
+			const size_t id = idAt(sources[i], pos[i]);
+			if (id < bestId) {
+				bestId = id;
+				best = i;
+			}
+		}
+		DU_ASSERT(best != (size_t)-1);
+
+		out->push_back(Item{ sources[best].store, (*sources[best].inds)[pos[best]] });
+		pos[best]++;
+	}
+}
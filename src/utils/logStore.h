@@ -0,0 +1,114 @@
+#ifndef __ABB_UTILS_LOGSTORE_H__
+#define __ABB_UTILS_LOGSTORE_H__
+
+#include <stdint.h>
+#include <deque>
+#include <vector>
+#include <string>
+#include <memory>
+#include <unordered_map>
+
+namespace ABB {
+	namespace utils {
+		/*
+			Storage for log entries: messages are packed into big chunks (an arena) and module/file names are interned,
+			so an entry is just a few numbers and a pointer.
+			Entries are addressed by an index that keeps counting up, so indices stay valid while old entries get evicted.
+		*/
+		class LogStore {
+		public:
+			typedef uint32_t name_t; // interned string, 0 = ""
+
+			struct Chunk {
+				std::unique_ptr<char[]> data; // messages, each null terminated
+				size_t size;
+				size_t used = 0;
+				size_t firstEntry; // index of the entry whose message starts at data
+
+				Chunk(size_t size, size_t firstEntry);
+			};
+
+			struct Entry {
+				const char* msg; // points into a chunk
+				uint32_t msgLen;
+				uint8_t level;
+				name_t module;
+				name_t fileName;
+				int lineNum;
+				uint32_t count; // how often this message was logged in a row
+
+				size_t id;
+			};
+
+			static constexpr size_t defChunkSize = 64 * 1024;
+		private:
+			size_t maxEntries;
+
+			std::deque<Entry> entries;
+			size_t entriesBegin = 0; // index of entries[0]
+			std::deque<std::shared_ptr<Chunk>> chunks;
+			std::vector<std::deque<size_t>> levelInds; // [level] = indices of all entries with that level
+
+			std::vector<std::string> names;
+			std::unordered_map<std::string, name_t> nameIds;
+			std::unordered_map<const void*, name_t> namePtrIds; // most names are string literals, so we can skip hashing the string
+
+			const char* storeMsg(const char* msg, size_t msgLen, size_t ind); // copies the message into the chunks, for the entry at ind
+			void evict();
+		public:
+			LogStore(size_t maxEntries);
+			LogStore(const LogStore& src); // copies the messages into own chunks, chunks are never shared between stores
+			LogStore& operator=(const LogStore& src);
+
+			size_t add(uint8_t level, const char* msg, size_t msgLen, const char* module, const char* fileName, int lineNum, size_t id); // returns the index of the new entry
+			bool repeatLast(uint8_t level, const char* msg, size_t msgLen, const char* module, const char* fileName, int lineNum); // increments the count of the newest entry if it is the same message
+			void clear();
+
+			void setMaxEntries(size_t maxEntries); // 0 = unlimited
+			size_t getMaxEntries() const;
+
+			size_t begin() const; // index of the oldest entry
+			size_t end() const; // one after the index of the newest entry
+			size_t size() const;
+			bool has(size_t ind) const;
+			const Entry& get(size_t ind) const;
+			const std::deque<size_t>& getLevelInds(uint8_t level) const;
+			const std::deque<std::shared_ptr<Chunk>>& getChunks() const; // the messages of consecutive entries are consecutive in the chunks
+
+			name_t intern(const char* str);
+			const std::string& getName(name_t name) const;
+
+			size_t sizeBytes() const;
+
+			/*
+				All entries of some stores with a minimum level, ordered by id, merged from the level index lists on the fly.
+				Only the lists get referenced, so setting one up is O(number of lists) and changing the filter is instant.
+			*/
+			class View {
+			public:
+				struct Item {
+					const LogStore* store;
+					size_t ind;
+				};
+			private:
+				struct Source {
+					const LogStore* store;
+					const std::deque<size_t>* inds;
+				};
+				std::vector<Source> sources;
+
+				size_t idAt(const Source& source, size_t i) const;
+				size_t lowerBound(const Source& source, size_t id) const; // first position in source with an id >= id
+			public:
+				void clear();
+				void addStore(const LogStore* store, uint8_t minLevel);
+
+				size_t size() const;
+				size_t rankOf(size_t id) const; // number of entries with a smaller id
+				void get(size_t from, size_t to, std::vector<Item>* out) const; // appends the entries at positions [from, to)
+			};
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,109 @@
+#include "mappedFile.h"
+
+#include <stdexcept>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__EMSCRIPTEN__)
+#include "StringUtils.h"
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+ABB::utils::MappedFile::MappedFile(const char* path) {
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		throw std::runtime_error(std::string("Could not open file: ") + path);
+	fileHandle = file;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize)) {
+		CloseHandle(file);
+		throw std::runtime_error(std::string("Could not get size of file: ") + path);
+	}
+	len = (size_t)fileSize.QuadPart;
+	if (len == 0) {
+		ptr = "";
+		return;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL) {
+		CloseHandle(file);
+		throw std::runtime_error(std::string("Could not map file: ") + path);
+	}
+	mappingHandle = mapping;
+
+	ptr = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (ptr == NULL) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		throw std::runtime_error(std::string("Could not map file: ") + path);
+	}
+}
+ABB::utils::MappedFile::~MappedFile() {
+	if (mappingHandle) {
+		UnmapViewOfFile(ptr);
+		CloseHandle((HANDLE)mappingHandle);
+	}
+	if (fileHandle)
+		CloseHandle((HANDLE)fileHandle);
+}
+
+#elif defined(__EMSCRIPTEN__)
+ABB::utils::MappedFile::MappedFile(const char* path) {
+	buf = StringUtils::loadFileIntoString(path);
+	ptr = buf.c_str();
+	len = buf.size();
+}
+ABB::utils::MappedFile::~MappedFile() {
+
+}
+
+#else
+ABB::utils::MappedFile::MappedFile(const char* path) {
+	fd = open(path, O_RDONLY);
+	if (fd == -1)
+		throw std::runtime_error(std::string("Could not open file: ") + path);
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		throw std::runtime_error(std::string("Could not get size of file: ") + path);
+	}
+	len = (size_t)st.st_size;
+	if (len == 0) {
+		ptr = "";
+		return;
+	}
+
+	void* addr = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (addr == MAP_FAILED) {
+		close(fd);
+		throw std::runtime_error(std::string("Could not map file: ") + path);
+	}
+#if defined(MADV_SEQUENTIAL)
+	madvise(addr, len, MADV_SEQUENTIAL); // we parse it front to back
+#endif
+	ptr = (const char*)addr;
+}
+ABB::utils::MappedFile::~MappedFile() {
+	if (len > 0)
+		munmap((void*)ptr, len);
+	if (fd != -1)
+		close(fd);
+}
+#endif
+
+const char* ABB::utils::MappedFile::data() const {
+	return ptr;
+}
+size_t ABB::utils::MappedFile::size() const {
+	return len;
+}
@@ -0,0 +1,37 @@
+#ifndef __ABB_UTILS_MAPPEDFILE_H__
+#define __ABB_UTILS_MAPPEDFILE_H__
+
+#include <cstddef>
+#include <string>
+
+namespace ABB {
+	namespace utils {
+		// read only view of a whole file, memory mapped where possible (so big files dont have to be copied).
+		// The file isnt locked, so keep it only as long as needed: if it gets truncated while mapped, reading past the new end crashes (SIGBUS on posix)
+		class MappedFile {
+		private:
+			const char* ptr = nullptr;
+			size_t len = 0;
+
+#if defined(_WIN32)
+			void* fileHandle = nullptr;
+			void* mappingHandle = nullptr;
+#elif defined(__EMSCRIPTEN__)
+			std::string buf; // no real files anyway, so we just load it
+#else
+			int fd = -1;
+#endif
+		public:
+			MappedFile(const char* path); // throws std::runtime_error if the file cant be opened/mapped
+			~MappedFile();
+
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+
+			const char* data() const;
+			size_t size() const;
+		};
+	}
+}
+
+#endif
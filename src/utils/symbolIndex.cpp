@@ -0,0 +1,168 @@
+#include "symbolIndex.h"
+
+#include <algorithm>
+
+#include "DataUtilsSize.h"
+
+ABB::utils::SymbolIndex::Intervals ABB::utils::SymbolIndex::Intervals::build(const EmuUtils::SymbolTable& table, const EmuUtils::SymbolTable::SymbolList& list) {
+	std::vector<Interval> symbols;
+	symbols.reserve(list.size());
+	for (size_t i = 0; i < list.size(); i++) {
+		const Symbol* symbol = table.getSymbol(list, i);
+		if (symbol->size == 0)
+			continue; // cant contain any address
+		symbols.push_back({ symbol->value, symbol->addrEnd(), symbol });
+	}
+
+	// outer symbols first, so inner ones end up on top of the stack
+	std::stable_sort(symbols.begin(), symbols.end(), [](const Interval& a, const Interval& b) {
+		if (a.start != b.start)
+			return a.start < b.start;
+		return a.end > b.end;
+	});
+
+	Intervals out;
+	std::vector<const Interval*> open;
+	addr_t pos = 0;
+	auto push = [&](addr_t start, addr_t end, const Symbol* symbol) {
+		if (out.intervals.size() > 0 && out.intervals.back().end == start && out.intervals.back().symbol == symbol)
+			out.intervals.back().end = end;
+		else
+			out.intervals.push_back({ start, end, symbol });
+	};
+	// everything in [pos, upTo) belongs to the innermost open symbol that is still going
+	auto advance = [&](addr_t upTo) {
+		while (open.size() > 0 && pos < upTo) {
+			const Interval* top = open.back();
+			if (top->end <= pos) {
+				open.pop_back();
+				continue;
+			}
+			const addr_t end = std::min(top->end, upTo);
+			push(pos, end, top->symbol);
+			pos = end;
+		}
+		pos = std::max(pos, upTo);
+	};
+
+	addr_t maxEnd = 0;
+	for (const Interval& symbol : symbols) {
+		advance(symbol.start);
+		open.push_back(&symbol);
+		maxEnd = std::max(maxEnd, symbol.end);
+	}
+	advance(maxEnd);
+
+	out.intervals.shrink_to_fit();
+	out.starts.reserve(out.intervals.size());
+	for (const Interval& interval : out.intervals)
+		out.starts.push_back(interval.start);
+
+	return out;
+}
+
+const ABB::utils::SymbolIndex::Interval* ABB::utils::SymbolIndex::Intervals::find(addr_t addr) const {
+	auto it = std::upper_bound(starts.begin(), starts.end(), addr);
+	if (it == starts.begin())
+		return nullptr;
+	const Interval& interval = intervals[(it - starts.begin()) - 1];
+	return addr < interval.end ? &interval : nullptr;
+}
+
+std::pair<const ABB::utils::SymbolIndex::Interval*, const ABB::utils::SymbolIndex::Interval*> ABB::utils::SymbolIndex::Intervals::getRange(addr_t from, addr_t to) const {
+	const Interval* const begin = intervals.data();
+	size_t first = std::upper_bound(starts.begin(), starts.end(), from) - starts.begin();
+	if (first > 0 && intervals[first - 1].end > from)
+		first--;
+	const size_t last = std::lower_bound(starts.begin() + first, starts.end(), to) - starts.begin();
+	return { begin + first, begin + std::max(first, last) };
+}
+
+size_t ABB::utils::SymbolIndex::Intervals::size() const {
+	return intervals.size();
+}
+
+size_t ABB::utils::SymbolIndex::Intervals::sizeBytes() const {
+	size_t sum = 0;
+
+	sum += DataUtils::approxSizeOf(starts);
+	sum += intervals.capacity() * sizeof(Interval);
+
+	return sum;
+}
+
+ABB::utils::SymbolIndex::Intervals::Cursor::Cursor(const Intervals* intervals) : intervals(intervals) {
+
+}
+
+const ABB::utils::SymbolIndex::Symbol* ABB::utils::SymbolIndex::Intervals::Cursor::getSymbol(addr_t addr) {
+	if (!intervals || intervals->intervals.size() == 0)
+		return nullptr;
+
+	const std::vector<Interval>& list = intervals->intervals;
+	if (ind >= list.size() || addr < list[ind].start) {
+		if (ind == 0 || addr < list[ind - 1].end) { // went backwards, start over
+			ind = std::upper_bound(intervals->starts.begin(), intervals->starts.end(), addr) - intervals->starts.begin();
+			if (ind > 0)
+				ind--;
+		}
+	}
+	while (ind < list.size() && list[ind].end <= addr)
+		ind++;
+
+	if (ind < list.size() && list[ind].start <= addr)
+		return list[ind].symbol;
+	return nullptr;
+}
+
+ABB::utils::SymbolIndex::SymbolIndex(const EmuUtils::SymbolTable* table) : table(table) {
+
+}
+
+void ABB::utils::SymbolIndex::invalidate() {
+	ram = Cached();
+	rom = Cached();
+	generation++;
+}
+size_t ABB::utils::SymbolIndex::getGeneration() const {
+	return generation;
+}
+
+const ABB::utils::SymbolIndex::Intervals& ABB::utils::SymbolIndex::get(Cached& cached, const EmuUtils::SymbolTable::SymbolList& list) const {
+	if (!cached.intervals || cached.listData != (const void*)list.data() || cached.listSize != list.size()) {
+		cached.intervals = std::make_shared<const Intervals>(Intervals::build(*table, list));
+		cached.listData = list.data();
+		cached.listSize = list.size();
+	}
+	return *cached.intervals;
+}
+
+const ABB::utils::SymbolIndex::Intervals& ABB::utils::SymbolIndex::getRam() const {
+	return get(ram, table->getSymbolsRam());
+}
+const ABB::utils::SymbolIndex::Intervals& ABB::utils::SymbolIndex::getRom() const {
+	return get(rom, table->getSymbolsRom());
+}
+
+const ABB::utils::SymbolIndex::Symbol* ABB::utils::SymbolIndex::getSymbolByValue(addr_t addr, const EmuUtils::SymbolTable::SymbolList& list) const {
+	const Interval* interval = nullptr;
+	if (&list == &table->getSymbolsRam())
+		interval = getRam().find(addr);
+	else if (&list == &table->getSymbolsRom())
+		interval = getRom().find(addr);
+	else
+		return table->getSymbolByValue(addr, list);
+
+	return interval ? interval->symbol : nullptr;
+}
+
+size_t ABB::utils::SymbolIndex::sizeBytes() const {
+	size_t sum = 0;
+
+	sum += sizeof(table);
+	sum += sizeof(ram) + (ram.intervals ? ram.intervals->sizeBytes() : 0);
+	sum += sizeof(rom) + (rom.intervals ? rom.intervals->sizeBytes() : 0);
+	sum += sizeof(generation);
+
+	return sum;
+}
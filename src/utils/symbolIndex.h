@@ -0,0 +1,78 @@
+#ifndef __ABB_UTILS_SYMBOLINDEX_H__
+#define __ABB_UTILS_SYMBOLINDEX_H__
+
+#include <vector>
+#include <memory>
+#include <utility>
+
+#include "SymbolTable.h"
+
+namespace ABB {
+	namespace utils {
+		// address -> symbol lookups for the RAM and ROM symbols of a SymbolTable, shared by all views
+		class SymbolIndex {
+		public:
+			typedef EmuUtils::SymbolTable::symb_size_t addr_t;
+			typedef EmuUtils::SymbolTable::Symbol Symbol;
+
+			struct Interval {
+				addr_t start;
+				addr_t end; // exclusive
+				const Symbol* symbol;
+			};
+
+			// immutable, sorted and non overlapping (if symbols overlap, the one that starts last wins)
+			class Intervals {
+			private:
+				std::vector<addr_t> starts; // same order as intervals, kept separate for a cache friendly binary search
+				std::vector<Interval> intervals;
+			public:
+				static Intervals build(const EmuUtils::SymbolTable& table, const EmuUtils::SymbolTable::SymbolList& list);
+
+				const Interval* find(addr_t addr) const; // O(log n), nullptr if no symbol contains addr
+				std::pair<const Interval*, const Interval*> getRange(addr_t from, addr_t to) const; // all intervals overlapping [from, to)
+
+				size_t size() const;
+				size_t sizeBytes() const;
+
+				// for queries with (mostly) increasing addresses, like drawing rows of bytes
+				class Cursor {
+				private:
+					const Intervals* intervals;
+					size_t ind = 0;
+				public:
+					Cursor(const Intervals* intervals); // intervals may be null
+					const Symbol* getSymbol(addr_t addr); // amortized O(1) if addr doesnt decrease
+				};
+			};
+		private:
+			const EmuUtils::SymbolTable* table;
+
+			struct Cached {
+				std::shared_ptr<const Intervals> intervals;
+				const void* listData = nullptr; // to notice changes that didnt call invalidate()
+				size_t listSize = 0;
+			};
+			mutable Cached ram;
+			mutable Cached rom;
+			size_t generation = 0;
+
+			const Intervals& get(Cached& cached, const EmuUtils::SymbolTable::SymbolList& list) const;
+		public:
+			SymbolIndex(const EmuUtils::SymbolTable* table);
+
+			void invalidate(); // has to be called when the symbols of the table change
+			size_t getGeneration() const; // changes on every invalidate(), for other caches that depend on the table
+
+			const Intervals& getRam() const; // gets built on first use after a change
+			const Intervals& getRom() const;
+
+			// like SymbolTable::getSymbolByValue, but uses the index if list is the RAM or ROM list of the table
+			const Symbol* getSymbolByValue(addr_t addr, const EmuUtils::SymbolTable::SymbolList& list) const;
+
+			size_t sizeBytes() const;
+		};
+	}
+}
+
+#endif